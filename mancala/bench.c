@@ -0,0 +1,698 @@
+/*
+ * project:  Mancalamax
+ * file:     bench.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "state.h"
+#include "minimax.h"
+#include "scheduler.h"
+#include "mcts.h"
+#include "evalcache.h"
+#include "nnue.h"
+#include "selfplay.h"
+
+
+#define PERFT_MAX_DEPTH 11
+
+/**
+ * Known perft counts (positions at each depth) of a starting position,
+ * from the original GameState_move implementation. 0 means unknown.
+ */
+typedef struct PerftCase {
+    int pits;
+    int stones;
+    unsigned long long counts[PERFT_MAX_DEPTH];
+} PerftCase;
+
+/**
+ * A stored position for the search benchmark.
+ */
+typedef struct BenchPosition {
+    const char* name;
+    int pits;
+    int player1[6];
+    int player2[6];
+    int store1, store2;
+    int ply;
+    int turn;
+} BenchPosition;
+
+static const PerftCase perftCases[] = {
+    {6, 4, {6ULL, 40ULL, 215ULL, 1097ULL, 5483ULL, 27115ULL, 133537ULL, 656090ULL, 3216380ULL, 15712503ULL, 76434355ULL}},
+    {4, 3, {4ULL, 18ULL, 62ULL, 196ULL, 611ULL, 1879ULL, 5787ULL, 17588ULL, 52205ULL, 150775ULL, 424497ULL}},
+    {3, 2, {3ULL, 10ULL, 25ULL, 53ULL, 110ULL, 204ULL, 358ULL, 585ULL, 868ULL}},
+    {8, 5, {8ULL, 70ULL, 513ULL, 3642ULL, 25190ULL, 172584ULL, 1176413ULL, 8010442ULL, 54420872ULL}},
+    {6, 6, {6ULL, 40ULL, 220ULL, 1216ULL, 6773ULL, 37202ULL, 204903ULL, 1111611ULL, 6001573ULL, 32014850ULL, 169096174ULL}},
+};
+
+static const BenchPosition benchPositions[] = {
+    {"start",    6, {4, 4, 4, 4, 4, 4}, {4, 4, 4, 4, 4, 4}, 0, 0, 1, 0},
+    {"opening",  6, {7, 5, 0, 6, 1, 2}, {0, 7, 6, 1, 6, 1}, 3, 3, 7, 0},
+    {"early",    6, {6, 0, 0, 8, 7, 0}, {0, 1, 8, 1, 4, 1}, 9, 3, 13, 1},
+    {"middle",   6, {1, 1, 2, 2, 1, 2}, {1, 0, 6, 9, 0, 1}, 10, 12, 21, 0},
+    {"late",     6, {0, 1, 1, 1, 1, 3}, {2, 1, 10, 3, 2, 3}, 8, 12, 29, 1},
+    {"endgame",  6, {0, 3, 2, 0, 0, 2}, {3, 0, 1, 4, 0, 0}, 19, 14, 37, 1},
+};
+
+/**
+ * Variants for the MCTS benchmark, from the standard board to ones too large
+ * for alpha-beta to search usefully.
+ */
+static const int mctsVariants[][2] = {{6, 4}, {8, 6}, {12, 8}, {16, 12}};
+
+#define PERFT_CASES ((int)(sizeof(perftCases) / sizeof(perftCases[0])))
+#define BENCH_POSITIONS ((int)(sizeof(benchPositions) / sizeof(benchPositions[0])))
+#define MCTS_VARIANTS ((int)(sizeof(mctsVariants) / sizeof(mctsVariants[0])))
+
+/**
+ * Helper function to read the monotonic clock in seconds.
+ */
+static double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Count the positions at a given depth below a state.
+ */
+static unsigned long long perft(GameState state, const int depth) {
+    if (depth == 0) return 1;
+
+    MoveList moves;
+    GameState_generateMoves(state, &moves);
+    if (depth == 1) return (unsigned long long)moves.size;
+
+    unsigned long long count = 0;
+    GameStateUndo undo;
+
+    for (int i = 0; i < moves.size; i++) {
+        GameState_makeMove(state, moves.moves[i], &undo);
+        count += perft(state, depth - 1);
+        GameState_unmakeMove(state, &undo);
+    }
+
+    return count;
+}
+
+/**
+ * Run perft on every case up to a depth, and compare with the known counts.
+ *
+ * @return The number of mismatches
+ */
+static int benchPerft(const int maxDepth) {
+    int failures = 0;
+    printf("perft (positions at depth, make/unmake)\n");
+    printf("%-8s %5s %14s %14s %9s %10s\n", "variant", "depth", "count", "expected", "time (s)", "Mpos/s");
+
+    for (int c = 0; c < PERFT_CASES; c++) {
+        const PerftCase* const test = &perftCases[c];
+        GameState state = GameState_initCustom(test->pits, test->stones);
+
+        for (int depth = 1; depth <= maxDepth && depth <= PERFT_MAX_DEPTH; depth++) {
+            const unsigned long long expected = test->counts[depth - 1];
+            if (expected == 0) break;
+
+            const double start = nowSeconds();
+            const unsigned long long count = perft(state, depth);
+            const double elapsed = nowSeconds() - start;
+
+            char variant[16];
+            snprintf(variant, sizeof(variant), "%dx%d", test->pits, test->stones);
+            printf("%-8s %5d %14llu %14llu %9.3f %10.2f%s\n",
+                variant, depth, count, expected, elapsed,
+                elapsed > 0 ? (double)count / elapsed / 1e6 : 0,
+                count == expected ? "" : "  MISMATCH");
+
+            if (count != expected) failures++;
+        }
+
+        GameState_free(state);
+    }
+
+    return failures;
+}
+
+/**
+ * Search every stored position to a fixed depth, and report the throughput.
+ */
+static void benchSearch(const int depth) {
+    SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+    size_t totalNodes = 0;
+    double totalTime = 0;
+
+    printf("search (iterative deepening to depth %d)\n", depth);
+    printf("%-8s %4s %12s %9s %10s %6s %6s %8s %10s\n", "position", "move", "nodes", "time (s)", "knodes/s", "EBF", "cut@1", "allocs", "peak (B)");
+
+    for (int p = 0; p < BENCH_POSITIONS; p++) {
+        const BenchPosition* const pos = &benchPositions[p];
+        GameState state = new_GameState(pos->pits, pos->player1, pos->player2, pos->store1, pos->store2, pos->ply, pos->turn);
+
+        const double start = nowSeconds();
+        const int move = SearchContext_iterDep(ctx, state, 0, depth, NULL);
+        const double elapsed = nowSeconds() - start;
+
+        SearchStats stats;
+        SearchContext_getStats(ctx, &stats);
+        const size_t nodes = stats.nodes;
+        size_t peakBytes, allocations;
+        SearchContext_getMemoryStats(ctx, &peakBytes, &allocations);
+
+        printf("%-8s %4d %12zu %9.3f %10.1f %6.2f %6.3f %8zu %10zu\n",
+            pos->name, move, nodes, elapsed, elapsed > 0 ? (double)nodes / elapsed / 1e3 : 0,
+            stats.branchingFactor, stats.cutoffs > 0 ? (double)stats.cutoffsAt[0] / stats.cutoffs : 0,
+            allocations, peakBytes);
+
+        totalNodes += nodes;
+        totalTime += elapsed;
+        GameState_free(state);
+    }
+
+    printf("%-8s %4s %12zu %9.3f %10.1f\n", "total", "", totalNodes, totalTime, totalTime > 0 ? (double)totalNodes / totalTime / 1e3 : 0);
+    SearchContext_free(ctx);
+}
+
+/**
+ * A custom heuristic for the batch benchmark: the store difference, plus a
+ * quarter of the difference in stones left on each side.
+ */
+static double sideHeuristic(GameState state, const int player) {
+    const int other = player == 0 ? 1 : 0;
+    int side = 0;
+    for (int i = 0; i < state->pits; i++) side += state->players[player][i] - state->players[other][i];
+
+    return (double)(state->stores[player] - state->stores[other]) + 0.25 * side;
+}
+
+/**
+ * Batch version of sideHeuristic.
+ */
+static void sideHeuristicBatch(const struct GameState* states, const int count, const int player, double* values) {
+    for (int i = 0; i < count; i++) values[i] = sideHeuristic((GameState)&states[i], player);
+}
+
+/**
+ * Search every stored position with a custom heuristic, calling it child by
+ * child and then through its batch version. Both must find the same moves and
+ * scores.
+ *
+ * @return The number of positions where they differ
+ */
+static int benchBatch(const int depth) {
+    SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+    int mismatches = 0;
+
+    printf("batch (custom heuristic, iterative deepening to depth %d)\n", depth);
+    printf("%-8s %6s %4s %12s %12s %9s\n", "position", "mode", "move", "nodes", "heuristic", "time (s)");
+
+    for (int p = 0; p < BENCH_POSITIONS; p++) {
+        const BenchPosition* const pos = &benchPositions[p];
+        GameState state = new_GameState(pos->pits, pos->player1, pos->player2, pos->store1, pos->store2, pos->ply, pos->turn);
+        int moves[2];
+        double scores[2];
+
+        for (int mode = 0; mode < 2; mode++) {
+            SearchContext_setBatchHeuristic(ctx, sideHeuristic, mode == 0 ? NULL : sideHeuristicBatch);
+
+            const double start = nowSeconds();
+            moves[mode] = SearchContext_iterDep(ctx, state, 0, depth, sideHeuristic);
+            const double elapsed = nowSeconds() - start;
+
+            SearchStats stats;
+            SearchContext_getStats(ctx, &stats);
+            scores[mode] = stats.score;
+
+            printf("%-8s %6s %4d %12zu %12zu %9.3f\n",
+                pos->name, mode == 0 ? "single" : "batch", moves[mode], stats.nodes, stats.heuristicCalls, elapsed);
+        }
+
+        if (moves[0] != moves[1] || scores[0] != scores[1]) {
+            printf("%-8s mismatch: move %d score %g, batched move %d score %g\n", pos->name, moves[0], scores[0], moves[1], scores[1]);
+            mismatches++;
+        }
+
+        GameState_free(state);
+    }
+
+    printf("mismatches: %d\n", mismatches);
+    SearchContext_free(ctx);
+    return mismatches;
+}
+
+/**
+ * Search the starting position with increasing numbers of threads.
+ */
+static void benchThreads(const int depth, const int maxThreads) {
+    SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+    GameState state = GameState_initBasic();
+
+    printf("threads (start position, iterative deepening to depth %d)\n", depth);
+    printf("%7s %4s %12s %9s %8s\n", "threads", "move", "nodes", "time (s)", "speedup");
+    double baseline = 0;
+
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        const double start = nowSeconds();
+        const int move = SearchContext_iterDepParallel(ctx, state, 0, depth, NULL, threads);
+        const double elapsed = nowSeconds() - start;
+        if (threads == 1) baseline = elapsed;
+
+        printf("%7d %4d %12zu %9.3f %8.2f\n", threads, move, SearchContext_getNodes(ctx), elapsed, elapsed > 0 ? baseline / elapsed : 0);
+    }
+
+    GameState_free(state);
+    SearchContext_free(ctx);
+}
+
+/**
+ * Run many short searches at once on a Scheduler, as a server with many games
+ * would, and report the throughput and the deadlines missed.
+ */
+static void benchScheduler(const int jobs, const int threads) {
+    Scheduler scheduler = new_Scheduler(threads);
+    if (scheduler == NULL) {
+        fprintf(stderr, "could not start the scheduler\n");
+        return;
+    }
+
+    printf("scheduler (%d jobs on %d threads, 10-100 ms deadlines, 1 MB tables)\n", jobs, threads);
+    const double start = nowSeconds();
+
+    // Deadlines are spread out so the queues are ordered by more than submission.
+    for (int i = 0; i < jobs; i++) {
+        const BenchPosition* const pos = &benchPositions[i % BENCH_POSITIONS];
+        GameState state = new_GameState(pos->pits, pos->player1, pos->player2, pos->store1, pos->store2, pos->ply, pos->turn);
+        Scheduler_submit(scheduler, state, 10 + (i * 37) % 91, 64, NULL, (size_t)1 << 20, NULL, NULL);
+        GameState_free(state);
+    }
+
+    size_t nodes = 0;
+    int results = 0, late = 0;
+    double waitTime = 0, maxWait = 0;
+    SchedulerResult result;
+
+    while (Scheduler_takeResult(scheduler, &result, true)) {
+        results++;
+        nodes += result.nodes;
+        if (result.late) late++;
+        waitTime += result.waitTime;
+        if (result.waitTime > maxWait) maxWait = result.waitTime;
+    }
+
+    const double elapsed = nowSeconds() - start;
+    printf("%8s %9s %12s %10s %7s %12s %12s\n", "results", "time (s)", "nodes", "jobs/s", "late", "wait (ms)", "max wait");
+    printf("%8d %9.3f %12zu %10.1f %7d %12.1f %12.1f\n",
+        results, elapsed, nodes, elapsed > 0 ? results / elapsed : 0, late,
+        results > 0 ? waitTime / results : 0, maxWait);
+
+    Scheduler_free(scheduler);
+}
+
+/**
+ * A stand-in for an expensive evaluator: the score difference, adjusted by a
+ * weighted count of the stones on each side that takes a few microseconds.
+ */
+static double slowHeuristic(GameState state, const int player) {
+    const int opponent = player == 0 ? 1 : 0;
+    double material = 0;
+
+    for (int round = 0; round < 64; round++) {
+        for (int i = 0; i < state->pits; i++) {
+            material += (state->players[player][i] - state->players[opponent][i]) * (1.0 + i) / (64.0 * 100.0 * (1 + round));
+        }
+    }
+
+    return GameState_getScore(state, player) - GameState_getScore(state, opponent) + material;
+}
+
+/**
+ * Play the opening of a game with an expensive heuristic (the context keeps
+ * its table between moves, as in a game), without an evaluation cache and
+ * then with each replacement policy.
+ */
+static void benchEvalCache(const int depth, const int kilobytes) {
+    static const char* const names[] = {"none", "always", "fifo", "lru"};
+    const int plies = 16;
+
+    printf("evalcache (slow heuristic, %d plies searched to depth %d, %d KB caches)\n", plies, depth, kilobytes);
+    printf("%-8s %9s %12s %12s %9s\n", "policy", "time (s)", "evaluations", "cache hits", "hit rate");
+
+    for (int p = -1; p <= EVALCACHE_REPLACE_LRU; p++) {
+        SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+        EvalCache cache = p < 0 ? NULL : new_EvalCache((size_t)kilobytes * 1024, (EvalCachePolicy)p);
+        SearchContext_setKeepTable(ctx, true);
+        SearchContext_setEvalCache(ctx, cache);
+
+        GameState state = GameState_initBasic();
+        size_t calls = 0, hits = 0;
+        double elapsed = 0;
+
+        for (int i = 0; i < plies && !GameState_isTerminal(state); i++) {
+            const double start = nowSeconds();
+            const int move = SearchContext_iterDep(ctx, state, 0, depth, slowHeuristic);
+            elapsed += nowSeconds() - start;
+
+            SearchStats stats;
+            SearchContext_getStats(ctx, &stats);
+            calls += stats.heuristicCalls;
+            hits += stats.evalCacheHits;
+            GameState_moveInto(state, move, state);
+        }
+
+        printf("%-8s %9.3f %12zu %12zu %8.1f%%\n",
+            names[p + 1], elapsed, calls, hits, calls + hits > 0 ? 100.0 * hits / (calls + hits) : 0);
+
+        GameState_free(state);
+        SearchContext_free(ctx);
+        EvalCache_free(cache);
+    }
+}
+
+/**
+ * Play MCTS against alpha-beta on each variant, with the same time (and
+ * threads) per move, alternating who moves first.
+ */
+static void benchMCTS(const int timeLimit, const int games, const int threads) {
+    SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+    MCTS mcts = new_MCTS(MCTS_DEFAULT_NODES);
+    if (ctx == NULL || mcts == NULL) {
+        fprintf(stderr, "could not create the engines\n");
+        SearchContext_free(ctx);
+        MCTS_free(mcts);
+        return;
+    }
+
+    printf("mcts vs alpha-beta (%d ms per move, %d threads, %d games per variant)\n", timeLimit, threads, games);
+    printf("%-8s %5s %5s %6s %10s %10s %9s %9s\n", "variant", "wins", "draws", "losses", "playouts/s", "tree depth", "ab depth", "margin");
+
+    for (int v = 0; v < MCTS_VARIANTS; v++) {
+        const int pits = mctsVariants[v][0];
+        const int stones = mctsVariants[v][1];
+        int wins = 0, draws = 0, losses = 0;
+        size_t playouts = 0;
+        double mctsTime = 0;
+        long treeDepth = 0, mctsMoves = 0, abDepth = 0, abMoves = 0, margin = 0;
+
+        for (int g = 0; g < games; g++) {
+            const int mctsPlayer = g % 2;
+            GameState state = GameState_initCustom(pits, stones);
+
+            while (!GameState_isTerminal(state)) {
+                int move;
+
+                if (GameState_getCurrentTurn(state) == mctsPlayer) {
+                    move = MCTS_search(mcts, state, timeLimit, 0, threads);
+                    MCTSStats stats;
+                    MCTS_getStats(mcts, &stats);
+                    playouts += stats.playouts;
+                    mctsTime += stats.time;
+                    treeDepth += stats.depth;
+                    mctsMoves++;
+                } else {
+                    move = SearchContext_iterDepParallel(ctx, state, timeLimit, 1000, NULL, threads);
+                    SearchStats stats;
+                    SearchContext_getStats(ctx, &stats);
+                    abDepth += stats.completedDepth;
+                    abMoves++;
+                }
+
+                GameState_moveInto(state, move, state);
+            }
+
+            const int diff = GameState_getScore(state, mctsPlayer) - GameState_getScore(state, mctsPlayer == 0 ? 1 : 0);
+            if (diff > 0) wins++;
+            else if (diff < 0) losses++;
+            else draws++;
+            margin += diff;
+            GameState_free(state);
+        }
+
+        char variant[16];
+        snprintf(variant, sizeof(variant), "%dx%d", pits, stones);
+        printf("%-8s %5d %5d %6d %10.0f %10.1f %9.1f %+9.1f\n",
+            variant, wins, draws, losses,
+            mctsTime > 0 ? (double)playouts / mctsTime * 1000 : 0,
+            mctsMoves > 0 ? (double)treeDepth / mctsMoves : 0,
+            abMoves > 0 ? (double)abDepth / abMoves : 0,
+            games > 0 ? (double)margin / games : 0);
+    }
+
+    SearchContext_free(ctx);
+    MCTS_free(mcts);
+}
+
+/**
+ * Check a network's incrementally updated accumulators against evaluations from
+ * scratch over random games, compare the speed of the two, then search the
+ * stored positions with the network and with the default heuristic. The network
+ * has random weights, so this measures speed, not strength.
+ *
+ * @return The number of positions where the incremental value was wrong
+ */
+static int benchNnue(const int depth) {
+    const char* const path = "mancalamax_bench.nnue";
+    const int games = 200;
+
+    if (!Nnue_create(path, 6, 1)) {
+        fprintf(stderr, "could not write %s\n", path);
+        return 1;
+    }
+    Nnue nnue = new_Nnue(path);
+    remove(path);
+    if (nnue == NULL) {
+        fprintf(stderr, "could not open %s\n", path);
+        return 1;
+    }
+
+    // Play random games, updating one accumulator move by move.
+    unsigned int seed = 1;
+    NnueAccumulator acc;
+    size_t positions = 0;
+    int mismatches = 0;
+    double sum = 0;
+
+    double start = nowSeconds();
+    for (int g = 0; g < games; g++) {
+        GameState state = GameState_initBasic();
+        acc.pits = 0;
+
+        while (!GameState_isTerminal(state)) {
+            MoveList moves;
+            GameState_generateMoves(state, &moves);
+            GameState_moveInto(state, moves.moves[rand_r(&seed) % moves.size], state);
+
+            Nnue_update(nnue, &acc, state);
+            for (int player = 0; player < 2; player++) {
+                const double value = Nnue_evaluate(nnue, &acc, state, player);
+                if (value != Nnue_evaluateState(nnue, state, player)) mismatches++;
+                sum += value;
+            }
+            positions++;
+        }
+
+        GameState_free(state);
+    }
+    const double checkTime = nowSeconds() - start;
+
+    // Time evaluations from scratch alone over the same games, to separate the two.
+    seed = 1;
+    start = nowSeconds();
+    for (int g = 0; g < games; g++) {
+        GameState state = GameState_initBasic();
+
+        while (!GameState_isTerminal(state)) {
+            MoveList moves;
+            GameState_generateMoves(state, &moves);
+            GameState_moveInto(state, moves.moves[rand_r(&seed) % moves.size], state);
+            for (int player = 0; player < 2; player++) sum += Nnue_evaluateState(nnue, state, player);
+        }
+
+        GameState_free(state);
+    }
+    const double scratchTime = nowSeconds() - start;
+    const double incrementalTime = checkTime - scratchTime;
+
+    printf("nnue (random %dx%d network, %zu positions from %d random games)\n", NNUE_HIDDEN, NNUE_HIDDEN2, positions, games);
+    printf("%-12s %12s %9s\n", "evaluation", "Mevals/s", "mismatches");
+    printf("%-12s %12.2f %9d\n", "incremental", incrementalTime > 0 ? 2.0 * positions / incrementalTime / 1e6 : 0, mismatches);
+    printf("%-12s %12.2f\n", "scratch", scratchTime > 0 ? 2.0 * positions / scratchTime / 1e6 : 0);
+    printf("(checksum %.3f)\n\n", sum);
+
+    // Search the stored positions with each evaluator.
+    SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+    SearchContext_setNnue(ctx, nnue);
+
+    printf("search (iterative deepening to depth %d)\n", depth);
+    printf("%-10s %12s %9s %10s\n", "heuristic", "nodes", "time (s)", "knodes/s");
+
+    for (int h = 0; h < 2; h++) {
+        size_t nodes = 0;
+        double elapsed = 0;
+
+        for (int p = 0; p < BENCH_POSITIONS; p++) {
+            const BenchPosition* const pos = &benchPositions[p];
+            GameState state = new_GameState(pos->pits, pos->player1, pos->player2, pos->store1, pos->store2, pos->ply, pos->turn);
+
+            start = nowSeconds();
+            SearchContext_iterDep(ctx, state, 0, depth, h == 0 ? NULL : nnueHeuristic);
+            elapsed += nowSeconds() - start;
+
+            SearchStats stats;
+            SearchContext_getStats(ctx, &stats);
+            nodes += stats.nodes;
+            GameState_free(state);
+        }
+
+        printf("%-10s %12zu %9.3f %10.1f\n", h == 0 ? "default" : "nnue", nodes, elapsed, elapsed > 0 ? (double)nodes / elapsed / 1e3 : 0);
+    }
+
+    SearchContext_free(ctx);
+    Nnue_free(nnue);
+    return mismatches;
+}
+
+/**
+ * Rebuild the position of a self-play record.
+ */
+static GameState decodeRecord(const SelfPlayRecord* record, const int pits) {
+    int player1[GAMESTATE_MAX_PITS], player2[GAMESTATE_MAX_PITS];
+    for (int i = 0; i < pits; i++) {
+        player1[i] = record->pits[0][i];
+        player2[i] = record->pits[1][i];
+    }
+    return new_GameState(pits, player1, player2, record->stores[0], record->stores[1], record->ply, record->turn);
+}
+
+/**
+ * Generate self-play games, then read the file back as a trainer would: every
+ * record's move, replayed on its position, must give the next record's
+ * position, or end the game.
+ *
+ * @return The number of records whose move did not replay
+ */
+static int benchSelfPlay(const int games, const int depth, const int threads) {
+    const char* const path = "mancalamax_bench.play";
+    const int pits = 6;
+
+    SelfPlayOptions options = {0};
+    options.pits = pits;
+    options.games = games;
+    options.depth = depth;
+    options.randomPlies = 4;
+    options.threads = threads;
+    options.seed = 1;
+
+    SelfPlayStats stats;
+    const long count = SelfPlay_generate(path, &options, &stats);
+    FILE* const file = count < 0 ? NULL : fopen(path, "rb");
+    SelfPlayRecord* const records = (SelfPlayRecord*)malloc(sizeof(SelfPlayRecord) * (count > 0 ? count : 1));
+    const bool read = file != NULL && records != NULL
+        && fseek(file, 32, SEEK_SET) == 0
+        && fread(records, sizeof(SelfPlayRecord), count, file) == (size_t)count;
+    if (file != NULL) fclose(file);
+    remove(path);
+
+    if (!read) {
+        fprintf(stderr, "could not generate and read back %s\n", path);
+        free(records);
+        return 1;
+    }
+
+    int mismatches = 0;
+    size_t endings = 0;
+    for (long i = 0; i < count; i++) {
+        GameState state = decodeRecord(&records[i], pits);
+        const int move = records[i].move >= 0 ? records[i].move + 1 : -1;
+
+        MoveList moves;
+        GameState_generateMoves(state, &moves);
+        if (!MoveList_contains(&moves, move)) {
+            mismatches++;
+            GameState_free(state);
+            continue;
+        }
+
+        GameState_moveInto(state, move, state);
+        if (GameState_isTerminal(state)) {
+            endings++;
+        } else {
+            GameState next = i + 1 < count ? decodeRecord(&records[i + 1], pits) : NULL;
+            if (next == NULL || GameState_getHash(next) != GameState_getHash(state) || next->ply != state->ply) mismatches++;
+            GameState_free(next);
+        }
+
+        GameState_free(state);
+    }
+
+    printf("selfplay (%d games to depth %d, %d threads)\n", games, depth, threads);
+    printf("%8s %10s %9s %8s %12s %10s\n", "games", "positions", "time (s)", "games/s", "positions/s", "mismatches");
+    printf("%8zu %10ld %9.3f %8.1f %12.0f %10d\n", stats.games, count, stats.time,
+        stats.time > 0 ? stats.games / stats.time : 0, stats.time > 0 ? stats.positions / stats.time : 0, mismatches);
+    if (endings != stats.games) printf("(%zu games ended, %zu played)\n", endings, stats.games);
+
+    free(records);
+    return mismatches + (endings != stats.games);
+}
+
+static int argOr(const int argc, char** argv, const int index, const int fallback) {
+    return argc > index ? atoi(argv[index]) : fallback;
+}
+
+
+/**
+ * Benchmarks for move generation and search.
+ *
+ * Usage:
+ *   mancalamax_bench                              perft to depth 8, then search to depth 18
+ *   mancalamax_bench perft [depth]                perft, checked against known counts
+ *   mancalamax_bench search [depth]               fixed-depth search of the stored positions
+ *   mancalamax_bench threads [depth] [threads]    parallel search with 1 .. threads threads
+ *   mancalamax_bench scheduler [jobs] [threads]   many short searches at once on a Scheduler
+ *   mancalamax_bench batch [depth]                custom heuristic called per child and as a batch
+ *   mancalamax_bench mcts [ms] [games] [threads]  MCTS against alpha-beta at equal time per move
+ *   mancalamax_bench evalcache [depth] [KB]       a game's opening with an expensive heuristic, by cache policy
+ *   mancalamax_bench nnue [depth]                 network evaluation: incremental against from scratch, and in search
+ *   mancalamax_bench selfplay [games] [depth] [threads]  self-play generation, with its records replayed
+ *
+ * Exits with status 1 if a perft count, an incrementally updated network value or a
+ * self-play record is wrong, or batched results differ.
+ */
+int main(int argc, char** argv) {
+    const char* const mode = argc > 1 ? argv[1] : "all";
+    int failures = 0;
+
+    if (strcmp(mode, "perft") == 0) {
+        failures = benchPerft(argOr(argc, argv, 2, 9));
+    } else if (strcmp(mode, "search") == 0) {
+        benchSearch(argOr(argc, argv, 2, 18));
+    } else if (strcmp(mode, "threads") == 0) {
+        benchThreads(argOr(argc, argv, 2, 18), argOr(argc, argv, 3, 4));
+    } else if (strcmp(mode, "scheduler") == 0) {
+        benchScheduler(argOr(argc, argv, 2, 1000), argOr(argc, argv, 3, 4));
+    } else if (strcmp(mode, "batch") == 0) {
+        failures = benchBatch(argOr(argc, argv, 2, 14));
+    } else if (strcmp(mode, "evalcache") == 0) {
+        benchEvalCache(argOr(argc, argv, 2, 14), argOr(argc, argv, 3, 256));
+    } else if (strcmp(mode, "nnue") == 0) {
+        failures = benchNnue(argOr(argc, argv, 2, 16));
+    } else if (strcmp(mode, "selfplay") == 0) {
+        failures = benchSelfPlay(argOr(argc, argv, 2, 100), argOr(argc, argv, 3, 8), argOr(argc, argv, 4, 2));
+    } else if (strcmp(mode, "mcts") == 0) {
+        benchMCTS(argOr(argc, argv, 2, 20), argOr(argc, argv, 3, 2), argOr(argc, argv, 4, 1));
+    } else if (strcmp(mode, "all") == 0) {
+        failures = benchPerft(8);
+        printf("\n");
+        benchSearch(18);
+    } else {
+        fprintf(stderr, "usage: %s [perft [depth] | search [depth] | threads [depth] [threads] | scheduler [jobs] [threads] | batch [depth] | mcts [ms] [games] [threads] | evalcache [depth] [KB] | nnue [depth] | selfplay [games] [depth] [threads]]\n", argv[0]);
+        return 2;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+/*
+ * project:  Mancalamax
+ * file:     book.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "book.h"
+#include "state.h"
+#include "minimax.h"
+
+
+#define BOOK_MAGIC "MNCLBOOK"
+#define BOOK_VERSION 1
+
+/**
+ * The header at the start of a book file.
+ */
+typedef struct BookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pits;
+    uint32_t stones;
+    uint32_t depth;
+    uint64_t entries;
+} BookHeader;
+
+/**
+ * A book entry.
+ */
+typedef struct BookEntry {
+    uint64_t key;
+    int16_t move;
+    uint16_t depth;
+    float score;
+} BookEntry;
+
+_Static_assert(sizeof(BookHeader) == 32, "book header must be 32 bytes");
+_Static_assert(sizeof(BookEntry) == 16, "book entry must be 16 bytes");
+
+/**
+ * A memory-mapped opening book.
+ */
+struct Book {
+    void* map;
+    size_t mapSize;
+    const BookEntry* entries;
+    size_t size;
+    int pits;
+    int stones;
+};
+
+/**
+ * A growable array of positions, used while building a book.
+ */
+typedef struct PositionList {
+    struct GameState* states;
+    size_t size;
+    size_t capacity;
+} PositionList;
+
+/**
+ * Shared state of the threads searching the positions of a book.
+ */
+typedef struct BookBuilder {
+    const PositionList* positions;
+    BookEntry* entries;
+    int depth;
+    atomic_size_t next;
+} BookBuilder;
+
+static bool PositionList_append(PositionList* list, GameState state) {
+    if (list->size == list->capacity) {
+        const size_t capacity = list->capacity == 0 ? 1024 : list->capacity * 2;
+        struct GameState* const states = (struct GameState*)realloc(list->states, sizeof(struct GameState) * capacity);
+        if (states == NULL) return false;
+
+        list->states = states;
+        list->capacity = capacity;
+    }
+
+    list->states[list->size++] = *state;
+    return true;
+}
+
+static int compareStates(const void* a, const void* b) {
+    const uint64_t x = ((const struct GameState*)a)->hash;
+    const uint64_t y = ((const struct GameState*)b)->hash;
+    return x < y ? -1 : x > y;
+}
+
+static int compareEntries(const void* a, const void* b) {
+    const uint64_t x = ((const BookEntry*)a)->key;
+    const uint64_t y = ((const BookEntry*)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Sort a list of positions by hash and remove the duplicates.
+ */
+static void PositionList_unique(PositionList* list) {
+    if (list->size == 0) return;
+    qsort(list->states, list->size, sizeof(struct GameState), compareStates);
+
+    size_t size = 1;
+    for (size_t i = 1; i < list->size; i++) {
+        if (list->states[i].hash != list->states[size - 1].hash) list->states[size++] = list->states[i];
+    }
+
+    list->size = size;
+}
+
+/**
+ * Builder thread: search positions until none are left.
+ */
+static void* builderThread(void* arg) {
+    BookBuilder* const builder = (BookBuilder*)arg;
+    SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+    if (ctx == NULL) return NULL;
+
+    while (true) {
+        const size_t i = atomic_fetch_add(&builder->next, 1);
+        if (i >= builder->positions->size) break;
+
+        GameState const state = &builder->positions->states[i];
+        BookEntry* const entry = &builder->entries[i];
+
+        entry->key = GameState_getHash(state);
+        entry->move = (int16_t)SearchContext_iterDep(ctx, state, 0, builder->depth, NULL);
+        entry->depth = (uint16_t)SearchContext_getCompletedDepth(ctx);
+        entry->score = (float)SearchContext_getScore(ctx);
+    }
+
+    SearchContext_free(ctx);
+    return NULL;
+}
+
+/**
+ * List every position reachable in fewer than a number of plies, before the game ends.
+ */
+static bool collectPositions(PositionList* positions, GameState start, const int plies) {
+    PositionList frontier = {NULL, 0, 0};
+    PositionList next = {NULL, 0, 0};
+    bool ok = PositionList_append(&frontier, start);
+
+    for (int ply = 0; ply < plies && ok && frontier.size > 0; ply++) {
+        PositionList_unique(&frontier);
+        next.size = 0;
+
+        for (size_t i = 0; i < frontier.size && ok; i++) {
+            GameState const state = &frontier.states[i];
+            if (GameState_isTerminal(state)) continue;
+            ok = PositionList_append(positions, state);
+
+            // The positions of the last ply have no successors in the book.
+            MoveList moves;
+            GameState_generateMoves(state, &moves);
+            for (int j = 0; j < moves.size && ok && ply + 1 < plies; j++) {
+                struct GameState child;
+                GameState_moveInto(state, moves.moves[j], &child);
+                ok = PositionList_append(&next, &child);
+            }
+        }
+
+        const PositionList swap = frontier;
+        frontier = next;
+        next = swap;
+    }
+
+    free(frontier.states);
+    free(next.states);
+
+    // The same position can be reached at different plies (after extra turns).
+    if (ok) PositionList_unique(positions);
+    return ok;
+}
+
+
+Book new_Book(const char* path) {
+    if (path == NULL) return NULL;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    BookHeader header;
+    struct stat info;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)
+        || memcmp(header.magic, BOOK_MAGIC, sizeof(header.magic)) != 0
+        || header.version != BOOK_VERSION
+        || fstat(fd, &info) != 0
+        || header.entries > ((uint64_t)info.st_size - sizeof(header)) / sizeof(BookEntry)) {
+        close(fd);
+        return NULL;
+    }
+
+    struct Book* const newBook = (Book)malloc(sizeof(struct Book));
+    if (newBook == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    newBook->mapSize = sizeof(header) + header.entries * sizeof(BookEntry);
+    newBook->map = mmap(NULL, newBook->mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (newBook->map == MAP_FAILED) {
+        free(newBook);
+        return NULL;
+    }
+
+    newBook->entries = (const BookEntry*)((const unsigned char*)newBook->map + sizeof(header));
+    newBook->size = header.entries;
+    newBook->pits = (int)header.pits;
+    newBook->stones = (int)header.stones;
+
+    return newBook;
+}
+
+void Book_free(Book book) {
+    if (book == NULL) return;
+    munmap(book->map, book->mapSize);
+    free(book);
+}
+
+size_t Book_getEntries(Book book) {
+    if (book == NULL) return 0;
+    return book->size;
+}
+
+bool Book_probe(Book book, GameState state, int* move, double* score) {
+    if (book == NULL || state == NULL || state->pits != book->pits) return false;
+
+    // Only states of the book's variant can be in it.
+    int total = state->stores[0] + state->stores[1];
+    for (int i = 0; i < state->pits; i++) total += state->players[0][i] + state->players[1][i];
+    if (total != 2 * book->pits * book->stones) return false;
+
+    // Binary search for the key.
+    const uint64_t key = GameState_getHash(state);
+    size_t low = 0, high = book->size;
+
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (book->entries[mid].key < key) low = mid + 1;
+        else high = mid;
+    }
+
+    if (low == book->size || book->entries[low].key != key) return false;
+
+    // Guard against hash collisions with positions outside the book.
+    MoveList moves;
+    GameState_generateMoves(state, &moves);
+    if (!MoveList_contains(&moves, book->entries[low].move)) return false;
+
+    if (move != NULL) *move = book->entries[low].move;
+    if (score != NULL) *score = book->entries[low].score;
+    return true;
+}
+
+long Book_build(const char* path, const int pits, const int stones, const int plies, const int depth, int threads) {
+    if (path == NULL || plies < 1 || depth < 1) return -1;
+    if (threads < 1) threads = 1;
+
+    GameState start = GameState_initCustom(pits, stones);
+    if (start == NULL) return -1;
+
+    PositionList positions = {NULL, 0, 0};
+    const bool collected = collectPositions(&positions, start, plies);
+    GameState_free(start);
+
+    BookEntry* const entries = collected ? (BookEntry*)calloc(positions.size + 1, sizeof(BookEntry)) : NULL;
+    pthread_t* const workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    if (entries == NULL || workers == NULL) {
+        free(positions.states);
+        free(entries);
+        free(workers);
+        return -1;
+    }
+
+    // Search the positions on all threads.
+    BookBuilder builder;
+    builder.positions = &positions;
+    builder.entries = entries;
+    builder.depth = depth;
+    atomic_init(&builder.next, 0);
+
+    int started = 0;
+    for (; started < threads - 1; started++) {
+        if (pthread_create(&workers[started], NULL, builderThread, &builder) != 0) break;
+    }
+
+    builderThread(&builder);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+    free(workers);
+    free(positions.states);
+
+    // Write the entries in key order, for binary search.
+    qsort(entries, positions.size, sizeof(BookEntry), compareEntries);
+
+    BookHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BOOK_MAGIC, sizeof(header.magic));
+    header.version = BOOK_VERSION;
+    header.pits = (uint32_t)pits;
+    header.stones = (uint32_t)stones;
+    header.depth = (uint32_t)depth;
+    header.entries = positions.size;
+
+    FILE* const file = fopen(path, "wb");
+    bool written = file != NULL
+        && fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(entries, sizeof(BookEntry), positions.size, file) == positions.size;
+    if (file != NULL && fclose(file) != 0) written = false;
+
+    free(entries);
+    return written ? (long)positions.size : -1;
+}
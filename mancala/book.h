@@ -0,0 +1,74 @@
+/*
+ * project:  Mancalamax
+ * file:     book.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "state.h"
+
+/**
+ * Opening book: the best move of every position reachable in the first few
+ * plies of a game, found by deep searches ahead of time.
+ *
+ * File layout (native byte order):
+ *   - A 32 byte header: magic "MNCLBOOK", uint32 version, uint32 pits,
+ *     uint32 stones per pit, uint32 search depth, and uint64 entries.
+ *   - 16 byte entries sorted by key: uint64 key (GameState_getHash), int16
+ *     best move, uint16 depth searched, and float score (for the player to move).
+ *
+ * A book file is memory-mapped read-only and shared, like an endgame database.
+ */
+typedef struct Book* Book;
+
+/**
+ * Open an opening book file.
+ *
+ * @param path The path of a file written by Book_build
+ * @return A pointer to the book, or NULL if the file could not be opened or is invalid
+ */
+extern Book new_Book(const char* path);
+
+/**
+ * Close an opening book.
+ */
+extern void Book_free(Book book);
+
+/**
+ * Returns the number of positions in a book.
+ */
+extern size_t Book_getEntries(Book book);
+
+/**
+ * Look up the best move of a state.
+ *
+ * @param book The book to search
+ * @param state The state to look up
+ * @param move Set to the best move (can be NULL)
+ * @param score Set to the score of the move for the player to move (can be NULL)
+ * @return Whether the state is in the book
+ */
+extern bool Book_probe(Book book, GameState state, int* move, double* score);
+
+/**
+ * Build an opening book for a game variant: every position reachable in the
+ * first few plies from GameState_initCustom(pits, stones) is searched to a
+ * fixed depth, with the positions spread over several threads.
+ *
+ * @param path The path of the file to write
+ * @param pits The number of pits per side
+ * @param stones The number of stones per pit at the start
+ * @param plies The number of plies to cover (the book holds positions before each of them)
+ * @param depth The depth to search each position to
+ * @param threads The number of threads to search with
+ * @return The number of positions in the book, or -1 if it could not be built
+ */
+extern long Book_build(const char* path, int pits, int stones, int plies, int depth, int threads);
+
+
+#endif //BOOK_H
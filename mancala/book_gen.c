@@ -0,0 +1,41 @@
+/*
+ * project:  Mancalamax
+ * file:     book_gen.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "book.h"
+
+
+/**
+ * Build an opening book file.
+ *
+ * Usage: mancalamax_book <file> <plies> <depth> [pits] [stones] [threads]
+ */
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <file> <plies> <depth> [pits] [stones] [threads]\n", argv[0]);
+        return 2;
+    }
+
+    const int plies = atoi(argv[2]);
+    const int depth = atoi(argv[3]);
+    const int pits = argc > 4 ? atoi(argv[4]) : 6;
+    const int stones = argc > 5 ? atoi(argv[5]) : 4;
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const int threads = argc > 6 ? atoi(argv[6]) : (cpus > 0 ? (int)cpus : 1);
+
+    const long entries = Book_build(argv[1], pits, stones, plies, depth, threads);
+    if (entries < 0) {
+        fprintf(stderr, "could not build %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s: %ld positions (%d pits, %d stones, %d plies, depth %d)\n", argv[1], entries, pits, stones, plies, depth);
+    return 0;
+}
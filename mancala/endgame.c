@@ -0,0 +1,436 @@
+/*
+ * project:  Mancalamax
+ * file:     endgame.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "endgame.h"
+#include "state.h"
+
+
+#define ENDGAME_MAGIC "MNCLEGDB"
+#define ENDGAME_VERSION 1
+
+// Marks a position that has not been solved yet.
+#define ENDGAME_UNKNOWN INT8_MIN
+
+// Positions handed to a generator thread at a time.
+#define ENDGAME_CHUNK 4096
+
+// Binomial coefficients needed to rank every position of the largest database.
+#define BINOMIAL_N (ENDGAME_MAX_STONES + 2 * GAMESTATE_MAX_PITS + 1)
+#define BINOMIAL_K (2 * GAMESTATE_MAX_PITS + 1)
+
+/**
+ * The header at the start of a database file.
+ */
+typedef struct EndgameHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pits;
+    uint32_t capacity;
+    uint32_t solved;
+    uint64_t entries;
+    uint8_t reserved[32];
+} EndgameHeader;
+
+_Static_assert(sizeof(EndgameHeader) == 64, "endgame header must be 64 bytes");
+
+/**
+ * A memory-mapped endgame database.
+ */
+struct Endgame {
+    void* map;
+    size_t mapSize;
+    const int8_t* values;
+    int pits;
+    int solved;
+    uint64_t offsets[ENDGAME_MAX_STONES + 2];
+};
+
+/**
+ * Shared state of the generator threads, while solving one stone count.
+ */
+typedef struct Generator {
+    _Atomic int8_t* values;
+    uint64_t offsets[ENDGAME_MAX_STONES + 2];
+    int pits;
+    int stones;
+    atomic_uint_fast64_t next;
+} Generator;
+
+// Saturating binomial coefficients, binomials[n][k] = C(n, k).
+static uint64_t binomials[BINOMIAL_N][BINOMIAL_K];
+static pthread_once_t binomialsOnce = PTHREAD_ONCE_INIT;
+
+static void initBinomials() {
+    for (int n = 0; n < BINOMIAL_N; n++) {
+        binomials[n][0] = 1;
+
+        for (int k = 1; k < BINOMIAL_K; k++) {
+            if (n == 0) {
+                binomials[n][k] = 0;
+                continue;
+            }
+
+            const uint64_t a = binomials[n - 1][k - 1];
+            const uint64_t b = binomials[n - 1][k];
+            binomials[n][k] = a > UINT64_MAX - b ? UINT64_MAX : a + b;
+        }
+    }
+}
+
+/**
+ * Returns the number of ways to distribute stones over a number of pits.
+ */
+static uint64_t distributions(const int stones, const int pits) {
+    if (pits == 0) return stones == 0 ? 1 : 0;
+    return binomials[stones + pits - 1][pits - 1];
+}
+
+/**
+ * Fill in the offset of each stone count's values, up to a capacity.
+ *
+ * @return The total number of values, or 0 if it does not fit in memory
+ */
+static uint64_t computeOffsets(uint64_t* offsets, const int pits, const int capacity) {
+    offsets[0] = 0;
+
+    for (int stones = 0; stones <= capacity; stones++) {
+        const uint64_t size = distributions(stones, 2 * pits);
+        if (size == UINT64_MAX || offsets[stones] > SIZE_MAX - sizeof(EndgameHeader) - size) return 0;
+        offsets[stones + 1] = offsets[stones] + size;
+    }
+
+    return offsets[capacity + 1];
+}
+
+/**
+ * Returns the rank of a distribution of stones over n pits, among all
+ * distributions of the same number of stones in lexicographic order.
+ */
+static uint64_t rankBoard(const int* board, const int n, int stones) {
+    uint64_t rank = 0;
+
+    // Skip every distribution with fewer stones in pit i (and the same pits before it).
+    for (int i = 0; i < n - 1; i++) {
+        const int rest = n - 1 - i;
+        rank += binomials[stones + rest][rest] - binomials[stones - board[i] + rest][rest];
+        stones -= board[i];
+    }
+
+    return rank;
+}
+
+/**
+ * Find the distribution of stones over n pits with a given rank (the inverse of rankBoard).
+ */
+static void unrankBoard(int* board, const int n, int stones, uint64_t rank) {
+    for (int i = 0; i < n - 1; i++) {
+        int count = 0;
+
+        while (rank >= distributions(stones - count, n - 1 - i)) {
+            rank -= distributions(stones - count, n - 1 - i);
+            count++;
+        }
+
+        board[i] = count;
+        stones -= count;
+    }
+
+    board[n - 1] = stones;
+}
+
+/**
+ * Step to the distribution with the next rank.
+ *
+ * @return Whether there is one
+ */
+static bool nextBoard(int* board, const int n) {
+    // Move one stone into the last pit that has stones after it, and put the rest in the last pit.
+    int rest = board[n - 1];
+
+    for (int i = n - 2; i >= 0; i--) {
+        if (rest > 0) {
+            board[i]++;
+            for (int j = i + 1; j < n - 1; j++) board[j] = 0;
+            board[n - 1] = rest - 1;
+            return true;
+        }
+
+        rest += board[i];
+    }
+
+    return false;
+}
+
+/**
+ * Read a state's board from the point of view of the player to move.
+ *
+ * @return The number of stones on the board
+ */
+static int readBoard(GameState state, int* board) {
+    const int pits = state->pits;
+    const int mover = state->currentTurn;
+    int stones = 0;
+
+    for (int i = 0; i < pits; i++) {
+        board[i] = state->players[mover][i];
+        board[pits + i] = state->players[mover == 0 ? 1 : 0][i];
+        stones += board[i] + board[pits + i];
+    }
+
+    return stones;
+}
+
+/**
+ * Solve a position, and any unsolved positions with the same number of stones
+ * it leads to. Moves that keep every stone on the board only sow stones
+ * towards the mover's store, so they never lead back to the same position
+ * and the recursion ends.
+ */
+static int solve(Generator* gen, const int* board, const int stones, const uint64_t rank) {
+    _Atomic int8_t* const value = &gen->values[gen->offsets[stones] + rank];
+    const int8_t known = atomic_load_explicit(value, memory_order_relaxed);
+    if (known != ENDGAME_UNKNOWN) return known;
+
+    // The "PIE" move is never available past ply 2.
+    const int pits = gen->pits;
+    struct GameState state;
+    GameState_set(&state, pits, board, board + pits, 0, 0, 3, 0);
+
+    MoveList moves;
+    GameState_generateMoves(&state, &moves);
+
+    // A player without moves can only watch the opponent collect the rest.
+    int best = moves.size == 0 ? -stones : -ENDGAME_MAX_STONES - 1;
+
+    for (int i = 0; i < moves.size; i++) {
+        struct GameState child;
+        GameState_moveInto(&state, moves.moves[i], &child);
+
+        int childBoard[2 * GAMESTATE_MAX_PITS];
+        const int childStones = readBoard(&child, childBoard);
+        int v = child.stores[0] - child.stores[1];
+
+        if (childStones > 0) {
+            const uint64_t childRank = rankBoard(childBoard, 2 * pits, childStones);
+            const int childValue = childStones == stones
+                ? solve(gen, childBoard, childStones, childRank)
+                : gen->values[gen->offsets[childStones] + childRank];
+
+            v += child.currentTurn == 0 ? childValue : -childValue;
+        }
+
+        if (v > best) best = v;
+    }
+
+    atomic_store_explicit(value, (int8_t)best, memory_order_relaxed);
+    return best;
+}
+
+/**
+ * Generator thread: solve chunks of the current stone count until none are left.
+ */
+static void* generatorThread(void* arg) {
+    Generator* const gen = (Generator*)arg;
+    const int n = 2 * gen->pits;
+    const uint64_t size = distributions(gen->stones, n);
+    int board[2 * GAMESTATE_MAX_PITS];
+
+    while (true) {
+        const uint64_t first = atomic_fetch_add(&gen->next, ENDGAME_CHUNK);
+        if (first >= size) break;
+
+        const uint64_t last = first + ENDGAME_CHUNK < size ? first + ENDGAME_CHUNK : size;
+        unrankBoard(board, n, gen->stones, first);
+
+        for (uint64_t rank = first; rank < last; rank++) {
+            solve(gen, board, gen->stones, rank);
+            nextBoard(board, n);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Check that a header belongs to a valid database.
+ */
+static bool validHeader(const EndgameHeader* header) {
+    return memcmp(header->magic, ENDGAME_MAGIC, sizeof(header->magic)) == 0
+        && header->version == ENDGAME_VERSION
+        && header->pits >= 1 && header->pits <= GAMESTATE_MAX_PITS
+        && header->capacity <= ENDGAME_MAX_STONES
+        && header->solved <= header->capacity + 1;
+}
+
+
+Endgame new_Endgame(const char* path) {
+    if (path == NULL) return NULL;
+    pthread_once(&binomialsOnce, initBinomials);
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    EndgameHeader header;
+    struct stat info;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || !validHeader(&header) || fstat(fd, &info) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    struct Endgame* const newDb = (Endgame)malloc(sizeof(struct Endgame));
+    if (newDb == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    newDb->pits = (int)header.pits;
+    newDb->solved = (int)header.solved;
+    const uint64_t entries = computeOffsets(newDb->offsets, newDb->pits, (int)header.capacity);
+
+    if (entries == 0 || entries != header.entries || (uint64_t)info.st_size < sizeof(header) + entries) {
+        free(newDb);
+        close(fd);
+        return NULL;
+    }
+
+    newDb->mapSize = sizeof(header) + entries;
+    newDb->map = mmap(NULL, newDb->mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (newDb->map == MAP_FAILED) {
+        free(newDb);
+        return NULL;
+    }
+
+    newDb->values = (const int8_t*)newDb->map + sizeof(header);
+    return newDb;
+}
+
+void Endgame_free(Endgame db) {
+    if (db == NULL) return;
+    munmap(db->map, db->mapSize);
+    free(db);
+}
+
+int Endgame_getPits(Endgame db) {
+    if (db == NULL) return 0;
+    return db->pits;
+}
+
+int Endgame_getMaxStones(Endgame db) {
+    if (db == NULL) return -1;
+    return db->solved - 1;
+}
+
+bool Endgame_probe(Endgame db, GameState state, int* value) {
+    if (db == NULL || state == NULL || state->pits != db->pits || state->ply == 2) return false;
+
+    int board[2 * GAMESTATE_MAX_PITS];
+    const int stones = readBoard(state, board);
+    if (stones >= db->solved) return false;
+
+    if (value != NULL) *value = db->values[db->offsets[stones] + rankBoard(board, 2 * db->pits, stones)];
+    return true;
+}
+
+int Endgame_generate(const char* path, const int pits, const int maxStones, int threads) {
+    if (path == NULL || pits < 1 || pits > GAMESTATE_MAX_PITS) return -1;
+    if (maxStones < 0 || maxStones > ENDGAME_MAX_STONES) return -1;
+    if (threads < 1) threads = 1;
+    pthread_once(&binomialsOnce, initBinomials);
+
+    const int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+
+    // Resume from an existing file for the same number of pits, or start a new one.
+    EndgameHeader header;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    if (info.st_size > 0) {
+        if (pread(fd, &header, sizeof(header), 0) != sizeof(header)
+            || !validHeader(&header) || header.pits != (uint32_t)pits) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, ENDGAME_MAGIC, sizeof(header.magic));
+        header.version = ENDGAME_VERSION;
+        header.pits = (uint32_t)pits;
+    }
+
+    if ((uint32_t)maxStones > header.capacity) header.capacity = (uint32_t)maxStones;
+
+    Generator* const gen = (Generator*)malloc(sizeof(Generator));
+    pthread_t* const workers = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    if (gen == NULL || workers == NULL) {
+        free(gen);
+        free(workers);
+        close(fd);
+        return -1;
+    }
+
+    header.entries = computeOffsets(gen->offsets, pits, (int)header.capacity);
+    const size_t mapSize = sizeof(header) + header.entries;
+    void* map = MAP_FAILED;
+
+    if (header.entries != 0 && ftruncate(fd, (off_t)mapSize) == 0)
+        map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        free(gen);
+        free(workers);
+        return -1;
+    }
+
+    EndgameHeader* const fileHeader = (EndgameHeader*)map;
+    memcpy(fileHeader, &header, sizeof(header));
+    gen->values = (_Atomic int8_t*)((unsigned char*)map + sizeof(header));
+    gen->pits = pits;
+
+    // Every position with k stones only leads to positions with k stones or fewer,
+    // so solve one stone count at a time, and record it once it is complete.
+    int status = 0;
+
+    for (int stones = (int)fileHeader->solved; stones <= maxStones && status == 0; stones++) {
+        memset((void*)(gen->values + gen->offsets[stones]), ENDGAME_UNKNOWN, gen->offsets[stones + 1] - gen->offsets[stones]);
+        gen->stones = stones;
+        atomic_init(&gen->next, 0);
+
+        int started = 0;
+        for (; started < threads - 1; started++) {
+            if (pthread_create(&workers[started], NULL, generatorThread, gen) != 0) break;
+        }
+
+        generatorThread(gen);
+        for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+        if (msync(map, mapSize, MS_SYNC) != 0) status = -1;
+        fileHeader->solved = (uint32_t)stones + 1;
+        if (msync(map, sizeof(header), MS_SYNC) != 0) status = -1;
+    }
+
+    munmap(map, mapSize);
+    free(gen);
+    free(workers);
+
+    return status;
+}
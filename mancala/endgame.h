@@ -0,0 +1,96 @@
+/*
+ * project:  Mancalamax
+ * file:     endgame.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "state.h"
+
+/**
+ * The largest number of stones on the board an endgame database can solve
+ * (values are stored in a signed byte).
+ */
+#define ENDGAME_MAX_STONES 126
+
+/**
+ * Endgame database: the exact value of every position with up to a given
+ * number of stones left on the board, for one number of pits per side.
+ *
+ * The value of a position is the net number of the remaining stones the
+ * player to move will collect under perfect play (stones they get minus
+ * stones their opponent gets). Positions are seen from the player to move
+ * (their pits first, then the opponent's), and indexed by the rank of their
+ * stone distribution among all distributions with the same number of stones.
+ *
+ * File layout (native byte order):
+ *   - A 64 byte header: magic "MNCLEGDB", uint32 version, uint32 pits,
+ *     uint32 capacity (the largest stone count the file has room for), uint32 solved
+ *     (stone counts 0 .. solved-1 are complete), uint64 entries, and padding.
+ *   - One int8 value per position, for 0 stones, then 1 stone, ... up to the
+ *     capacity. Each stone count holds C(stones + 2*pits - 1, 2*pits - 1)
+ *     positions, in lexicographic order of the pits.
+ *
+ * A database file is memory-mapped read-only and shared, so several
+ * processes probing the same file share one copy in the page cache.
+ * The "PIE" move is not part of endgame positions, so states where it is
+ * available are never found.
+ */
+typedef struct Endgame* Endgame;
+
+/**
+ * Open an endgame database file.
+ *
+ * @param path The path of a file written by Endgame_generate
+ * @return A pointer to the database, or NULL if the file could not be opened or is invalid
+ */
+extern Endgame new_Endgame(const char* path);
+
+/**
+ * Close an endgame database.
+ */
+extern void Endgame_free(Endgame db);
+
+/**
+ * Returns the number of pits per side of a database.
+ */
+extern int Endgame_getPits(Endgame db);
+
+/**
+ * Returns the largest number of stones on the board a database has solved (-1 if none).
+ */
+extern int Endgame_getMaxStones(Endgame db);
+
+/**
+ * Look up the value of a state.
+ *
+ * @param db The database to search
+ * @param state The state to look up
+ * @param value Set to the net number of the remaining stones the player to move will collect
+ * @return Whether the state is in the database
+ */
+extern bool Endgame_probe(Endgame db, GameState state, int* value);
+
+/**
+ * Solve all positions with up to maxStones stones on the board using
+ * retrograde analysis, and write them to a database file. Positions are
+ * solved one stone count at a time, since every move either keeps the stones
+ * on the board or removes some; the solved stone counts are recorded in the
+ * file after each one, so an interrupted run resumes where it stopped when
+ * called again with the same file.
+ *
+ * @param path The path of the file to write (or resume)
+ * @param pits The number of pits per side
+ * @param maxStones The largest number of stones on the board to solve
+ * @param threads The number of threads to solve with
+ * @return 0 on success, or -1 if the file could not be written or does not match
+ */
+extern int Endgame_generate(const char* path, int pits, int maxStones, int threads);
+
+
+#endif //ENDGAME_H
@@ -0,0 +1,46 @@
+/*
+ * project:  Mancalamax
+ * file:     endgame_gen.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "endgame.h"
+
+
+/**
+ * Generate (or resume generating) an endgame database file.
+ *
+ * Usage: mancalamax_endgame <file> <pits> <max stones> [threads]
+ */
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <file> <pits> <max stones> [threads]\n", argv[0]);
+        return 2;
+    }
+
+    const int pits = atoi(argv[2]);
+    const int maxStones = atoi(argv[3]);
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const int threads = argc > 4 ? atoi(argv[4]) : (cpus > 0 ? (int)cpus : 1);
+
+    if (Endgame_generate(argv[1], pits, maxStones, threads) != 0) {
+        fprintf(stderr, "could not generate %s (the file may belong to another number of pits)\n", argv[1]);
+        return 1;
+    }
+
+    Endgame db = new_Endgame(argv[1]);
+    if (db == NULL) {
+        fprintf(stderr, "could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s: %d pits, solved up to %d stones\n", argv[1], Endgame_getPits(db), Endgame_getMaxStones(db));
+    Endgame_free(db);
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * project:  Mancalamax
+ * file:     evalcache.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "evalcache.h"
+
+
+// Entries per slot for the policies that choose between several.
+#define EVALCACHE_WAYS 4
+
+// Mixed into the key of values computed for player 1, so the two players'
+// values of a position land in different slots.
+#define EVALCACHE_PLAYER_SALT 0x9e3779b97f4a7c15ULL
+
+/**
+ * A single cache entry: the value, and the key XORed with it. A reader that
+ * sees a half-written entry gets a key mismatch, and treats it as a miss. An
+ * unused entry is all zeros, which only matches key 0 (never used).
+ */
+typedef struct EvalEntry {
+    _Atomic uint64_t check;
+    _Atomic uint64_t value;
+} EvalEntry;
+
+/**
+ * Fixed-size evaluation cache. Slots hold ways entries each. For FIFO, order
+ * holds the next entry to replace in each slot; for LRU, it holds the time
+ * of each entry's last use, measured by a clock that ticks on every store.
+ * The heuristic is the one the entries were computed by (NULL before any).
+ */
+struct EvalCache {
+    EvalEntry* entries;
+    _Atomic uint32_t* order;
+    size_t slotMask;
+    int ways;
+    EvalCachePolicy policy;
+    _Atomic uint32_t clock;
+    EvalCacheHeuristic heuristic;
+};
+
+static uint64_t makeKey(GameState state, const int player) {
+    const uint64_t key = GameState_getHash(state) ^ (player == 0 ? 0 : EVALCACHE_PLAYER_SALT);
+    return key == 0 ? 1 : key;
+}
+
+static uint64_t doubleBits(const double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(const uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * Pick the entry of a slot to overwrite with a key: the key's own entry or an
+ * empty one if there is one, otherwise the one the policy chooses.
+ */
+static size_t chooseVictim(EvalCache cache, const size_t slot, const uint64_t key) {
+    const size_t first = slot * cache->ways;
+
+    for (int w = 0; w < cache->ways; w++) {
+        EvalEntry* const entry = &cache->entries[first + w];
+        const uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+        const uint64_t value = atomic_load_explicit(&entry->value, memory_order_relaxed);
+        if ((check ^ value) == key || (check == 0 && value == 0)) return first + w;
+    }
+
+    switch (cache->policy) {
+        case EVALCACHE_REPLACE_FIFO:
+            return first + atomic_fetch_add_explicit(&cache->order[slot], 1, memory_order_relaxed) % cache->ways;
+
+        case EVALCACHE_REPLACE_LRU: {
+            // Ages are compared as differences from now, so the clock can wrap around.
+            const uint32_t now = atomic_load_explicit(&cache->clock, memory_order_relaxed);
+            size_t victim = first;
+            uint32_t oldest = 0;
+
+            for (int w = 0; w < cache->ways; w++) {
+                const uint32_t age = now - atomic_load_explicit(&cache->order[first + w], memory_order_relaxed);
+                if (age > oldest) {
+                    oldest = age;
+                    victim = first + w;
+                }
+            }
+
+            return victim;
+        }
+
+        default:
+            return first;
+    }
+}
+
+
+EvalCache new_EvalCache(const size_t bytes, const EvalCachePolicy policy) {
+    const int ways = policy == EVALCACHE_REPLACE_ALWAYS ? 1 : EVALCACHE_WAYS;
+
+    // Bookkeeping per entry: LRU stamps every entry, FIFO keeps one counter per slot.
+    const size_t orderBytes = policy == EVALCACHE_REPLACE_LRU ? sizeof(uint32_t)
+        : policy == EVALCACHE_REPLACE_FIFO ? sizeof(uint32_t) / EVALCACHE_WAYS
+        : 0;
+    const size_t perEntry = sizeof(EvalEntry) + orderBytes;
+    if (bytes < sizeof(struct EvalCache) + perEntry * ways) return NULL;
+
+    // Round down to a power of two slots.
+    const size_t fit = (bytes - sizeof(struct EvalCache)) / perEntry / ways;
+    size_t slots = 1;
+    while (slots <= fit / 2) slots *= 2;
+
+    struct EvalCache* const newCache = (EvalCache)calloc(1, sizeof(struct EvalCache));
+    if (newCache == NULL) return NULL;
+
+    newCache->entries = (EvalEntry*)malloc(sizeof(EvalEntry) * slots * ways);
+    const size_t orders = policy == EVALCACHE_REPLACE_LRU ? slots * ways : slots;
+    newCache->order = policy == EVALCACHE_REPLACE_ALWAYS ? NULL : (_Atomic uint32_t*)malloc(sizeof(uint32_t) * orders);
+
+    if (newCache->entries == NULL || (policy != EVALCACHE_REPLACE_ALWAYS && newCache->order == NULL)) {
+        EvalCache_free(newCache);
+        return NULL;
+    }
+
+    newCache->slotMask = slots - 1;
+    newCache->ways = ways;
+    newCache->policy = policy;
+    EvalCache_clear(newCache);
+
+    return newCache;
+}
+
+void EvalCache_free(EvalCache cache) {
+    if (cache == NULL) return;
+    free(cache->entries);
+    free((void*)cache->order);
+    free(cache);
+}
+
+void EvalCache_clear(EvalCache cache) {
+    if (cache == NULL) return;
+
+    const size_t entries = (cache->slotMask + 1) * cache->ways;
+    for (size_t i = 0; i < entries; i++) {
+        atomic_store_explicit(&cache->entries[i].check, 0, memory_order_relaxed);
+        atomic_store_explicit(&cache->entries[i].value, 0, memory_order_relaxed);
+    }
+
+    if (cache->order != NULL) {
+        const size_t orders = cache->policy == EVALCACHE_REPLACE_LRU ? entries : cache->slotMask + 1;
+        for (size_t i = 0; i < orders; i++) atomic_store_explicit(&cache->order[i], 0, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&cache->clock, 0, memory_order_relaxed);
+}
+
+bool EvalCache_setHeuristic(EvalCache cache, EvalCacheHeuristic heuristic) {
+    if (cache == NULL || cache->heuristic == heuristic) return false;
+
+    EvalCache_clear(cache);
+    cache->heuristic = heuristic;
+    return true;
+}
+
+bool EvalCache_probe(EvalCache cache, GameState state, const int player, double* value) {
+    if (cache == NULL || state == NULL) return false;
+
+    const uint64_t key = makeKey(state, player);
+    const size_t first = (key & cache->slotMask) * cache->ways;
+
+    for (int w = 0; w < cache->ways; w++) {
+        EvalEntry* const entry = &cache->entries[first + w];
+        const uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+        const uint64_t valueBits = atomic_load_explicit(&entry->value, memory_order_relaxed);
+        if ((check ^ valueBits) != key) continue;
+
+        if (cache->policy == EVALCACHE_REPLACE_LRU) {
+            const uint32_t now = atomic_load_explicit(&cache->clock, memory_order_relaxed);
+            atomic_store_explicit(&cache->order[first + w], now, memory_order_relaxed);
+        }
+
+        *value = bitsDouble(valueBits);
+        return true;
+    }
+
+    return false;
+}
+
+void EvalCache_store(EvalCache cache, GameState state, const int player, const double value) {
+    if (cache == NULL || state == NULL) return;
+
+    const uint64_t key = makeKey(state, player);
+    const size_t slot = key & cache->slotMask;
+    const size_t index = chooseVictim(cache, slot, key);
+    EvalEntry* const entry = &cache->entries[index];
+    const uint64_t valueBits = doubleBits(value);
+
+    atomic_store_explicit(&entry->value, valueBits, memory_order_relaxed);
+    atomic_store_explicit(&entry->check, key ^ valueBits, memory_order_relaxed);
+
+    if (cache->policy == EVALCACHE_REPLACE_LRU) {
+        const uint32_t now = atomic_fetch_add_explicit(&cache->clock, 1, memory_order_relaxed) + 1;
+        atomic_store_explicit(&cache->order[index], now, memory_order_relaxed);
+    }
+}
+
+size_t EvalCache_getEntries(EvalCache cache) {
+    if (cache == NULL) return 0;
+    return (cache->slotMask + 1) * cache->ways;
+}
+
+EvalCachePolicy EvalCache_getPolicy(EvalCache cache) {
+    if (cache == NULL) return EVALCACHE_REPLACE_ALWAYS;
+    return cache->policy;
+}
@@ -0,0 +1,100 @@
+/*
+ * project:  Mancalamax
+ * file:     evalcache.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "state.h"
+
+/**
+ * How an EvalCache chooses the entry a new value replaces.
+ */
+typedef enum EvalCachePolicy {
+    EVALCACHE_REPLACE_ALWAYS,  // one entry per slot, always overwritten
+    EVALCACHE_REPLACE_FIFO,    // four entries per slot, the oldest stored is replaced
+    EVALCACHE_REPLACE_LRU      // four entries per slot, the least recently used is replaced
+} EvalCachePolicy;
+
+/**
+ * The heuristic whose values a cache holds (the same signature as a search Heuristic).
+ */
+typedef double (*EvalCacheHeuristic)(GameState state, int player);
+
+/**
+ * Fixed-size cache of heuristic values, keyed by a position's Zobrist hash and
+ * the player it was evaluated for. It lets a search look up the value of a
+ * leaf it has evaluated before (e.g. in an earlier iteration) instead of
+ * calling an expensive heuristic again.
+ *
+ * A cache can be shared by several search threads without locking: entries
+ * are verified against the probed key, so a torn write reads as a miss.
+ * EvalCache_clear must not run concurrently with probes or stores. Values are
+ * only meaningful for one heuristic: the cache remembers which one filled it
+ * (see EvalCache_setHeuristic), so it can only be used with one heuristic at a time.
+ */
+typedef struct EvalCache* EvalCache;
+
+/**
+ * Create a new, empty evaluation cache.
+ *
+ * @param bytes The most memory the cache may use (rounded down to a power of two entries)
+ * @param policy The replacement policy
+ * @return A pointer to the new EvalCache, or NULL if allocation failed or not even one slot fits
+ */
+extern EvalCache new_EvalCache(size_t bytes, EvalCachePolicy policy);
+
+/**
+ * Free the memory used by an EvalCache.
+ */
+extern void EvalCache_free(EvalCache cache);
+
+/**
+ * Remove all entries from an EvalCache.
+ */
+extern void EvalCache_clear(EvalCache cache);
+
+/**
+ * Declare the heuristic whose values will be probed and stored. If it differs
+ * from the one the cache's values were computed by, the cache is cleared.
+ * Like EvalCache_clear, this must not run concurrently with probes or stores.
+ *
+ * @param cache The cache
+ * @param heuristic The heuristic
+ * @return Whether the cache was cleared
+ */
+extern bool EvalCache_setHeuristic(EvalCache cache, EvalCacheHeuristic heuristic);
+
+/**
+ * Look up the value of a position.
+ *
+ * @param cache The cache to search
+ * @param state The position
+ * @param player The player the value was computed for
+ * @param value Set to the stored value on a hit
+ * @return Whether the position was found
+ */
+extern bool EvalCache_probe(EvalCache cache, GameState state, int player, double* value);
+
+/**
+ * Store the value of a position, replacing an entry as the cache's policy decides.
+ */
+extern void EvalCache_store(EvalCache cache, GameState state, int player, double value);
+
+/**
+ * Returns the number of entries in the cache.
+ */
+extern size_t EvalCache_getEntries(EvalCache cache);
+
+/**
+ * Returns the replacement policy of the cache.
+ */
+extern EvalCachePolicy EvalCache_getPolicy(EvalCache cache);
+
+
+#endif //EVALCACHE_H
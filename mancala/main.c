@@ -2,7 +2,7 @@
  * project:  Mancalamax
  * file:     main.c
  * author:   Ethan Mentzer
- * modified: 2025-03-08
+ * modified: 2026-10-16
  */
 
 #include <stdio.h>
@@ -10,6 +10,10 @@
 
 #include "state.h"
 #include "minimax.h"
+#include "endgame.h"
+#include "book.h"
+#include "ponder.h"
+#include "nnue.h"
 
 
 /**
@@ -23,25 +27,54 @@ double h2(GameState state, const int player) {
 }
 
 int main() {
+    SearchContext ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+
+    // Use an endgame database if one has been generated (see mancalamax_endgame).
+    Endgame endgame = new_Endgame("mancalamax.egdb");
+    SearchContext_setEndgame(ctx, endgame);
+
+    // Likewise for an opening book (see mancalamax_book).
+    Book book = new_Book("mancalamax.book");
+    SearchContext_setBook(ctx, book);
+
+    // And evaluate with a trained network, if there is one for this board.
+    Nnue nnue = new_Nnue("mancalamax.nnue");
+    nnueSetDefault(nnue);
+    const Heuristic evaluator = nnue != NULL ? nnueHeuristic : NULL;
+
+    // Think on the user's time, on the reply the last search expects. The
+    // context keeps what it learns over the game, so each search picks up
+    // where the previous one (or the ponder search) left off.
+    Ponder ponder = new_Ponder(ctx);
+
     // Create new initial board state.
     GameState state = GameState_initBasic();
     GameState_print(state, true);
 
     while (!GameState_isTerminal(state)) {
         int move;
+        const bool engineTurn = GameState_getCurrentTurn(state) == 0;
 
         // Player 0 is the algorithm, player 1 is a user.
-        if (GameState_getCurrentTurn(state) == 0) {
-            // Collect move from minimax.
-            move = minimaxIterDep(state, 1000, 1000, NULL);
+        if (engineTurn) {
+            // Collect move from minimax (continuing the ponder search if it guessed right).
+            move = Ponder_respond(ponder, state, 1000, 1000, evaluator);
 
             // SOME ALTERNATIVE COMPUTER MOVES BELOW (with and without the custom "h2" heuristic).
 
-            //move = minimaxIterDep(state, 1000, 1000, h2);
+            //move = Ponder_respond(ponder, state, 1000, 1000, h2);
+            //move = minimaxIterDep(state, 1000, 1000, NULL);
             //move = minimaxAlphaBeta(state, 12, NULL);
             //move = minimaxAlphaBeta(state, 12, h2);
 
             printf("MINIMAX SELECTED: %d\n", move);
+
+            SearchStats stats;
+            SearchContext_getStats(ctx, &stats);
+            printf("(depth %d%s from %d, score %.1f, %zu nodes, EBF %.2f, %.0f ms%s)\n",
+                stats.completedDepth, stats.aborted ? "+" : "", stats.firstDepth, stats.score,
+                stats.nodes, stats.branchingFactor, stats.time,
+                Ponder_wasHit(ponder) ? ", pondered" : "");
         } else {
             // Collect move from user.
             scanf("%d", &move);
@@ -53,7 +86,16 @@ int main() {
         state = newState;
 
         GameState_print(state, true);
+
+        // Once the user is to move, ponder until it is the algorithm's turn again.
+        if (engineTurn && GameState_getCurrentTurn(state) == 1 && !GameState_isTerminal(state))
+            Ponder_start(ponder, state, 1000, evaluator);
     }
 
+    Ponder_free(ponder);
     GameState_free(state);
+    SearchContext_free(ctx);
+    Endgame_free(endgame);
+    Book_free(book);
+    Nnue_free(nnue);
 }
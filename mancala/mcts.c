@@ -0,0 +1,452 @@
+/*
+ * project:  Mancalamax
+ * file:     mcts.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "mcts.h"
+#include "timer.h"
+
+
+// Exploration constant of PUCT.
+#define MCTS_C_PUCT 1.4
+
+// Weights of moves, for the priors of the tree policy and the choices of
+// playouts: captures get MOVE_WEIGHT_CAPTURE plus one per stone captured.
+#define MOVE_WEIGHT_QUIET 1
+#define MOVE_WEIGHT_CAPTURE 2
+#define MOVE_WEIGHT_EXTRA_TURN 4
+
+// Longest path the tree policy follows (the rest of the game is played out at random).
+#define MCTS_MAX_PATH 512
+
+// Expansion states of a node.
+#define NODE_LEAF 0
+#define NODE_EXPANDING 1
+#define NODE_EXPANDED 2
+
+/**
+ * A node of the tree: the position after a move. Results are kept for the
+ * player who made the move, as twice the score of each playout (2 for a win,
+ * 1 for a draw), so they are whole numbers that threads can add atomically.
+ *
+ * A thread that expands a node fills in its children, then publishes them by
+ * setting the expansion state (with release ordering); other threads only read
+ * firstChild and childCount once they see it.
+ */
+typedef struct MCTSNode {
+    _Atomic uint64_t reward;
+    _Atomic uint32_t visits;
+    _Atomic uint32_t virtualLoss;
+    uint32_t firstChild;
+    _Atomic uint8_t expansion;
+    int8_t move;
+    uint8_t childCount;
+    uint8_t mover;
+    float prior;
+} MCTSNode;
+
+/**
+ * One search thread: its time manager, random number state and statistics.
+ */
+typedef struct MCTSWorker {
+    MCTS mcts;
+    Timer timer;
+    uint64_t random;
+    size_t playouts;
+    int depth;
+} MCTSWorker;
+
+/**
+ * Monte Carlo tree search context: the tree, and the current search.
+ */
+struct MCTS {
+    MCTSNode* nodes;
+    size_t capacity;
+    atomic_size_t used;
+    atomic_bool full;
+
+    // The current search: its root, playout budget (claimed through started),
+    // and the flag that stops every worker once one runs out of time.
+    struct GameState root;
+    time_t timeLimit;
+    size_t maxPlayouts;
+    atomic_size_t started;
+    atomic_bool stop;
+
+    // Workers (worker 0 runs on the calling thread), kept for later searches.
+    MCTSWorker* workers;
+    pthread_t* threads;
+    int workerCount;
+
+    // Statistics of the most recent search.
+    double winRate;
+    double elapsed;
+};
+
+static MCTS defaultMCTS = NULL;
+
+/**
+ * Returns a random number from a worker's xorshift generator (cheaper than
+ * rand_r, which matters when every move of a playout needs one).
+ */
+static uint64_t nextRandom(MCTSWorker* worker) {
+    uint64_t x = worker->random;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    worker->random = x;
+    return x;
+}
+
+/**
+ * Returns how strongly a move is preferred: extra turns and captures tend to be good.
+ */
+static int moveWeight(GameState state, const int move) {
+    int captured;
+    const int flags = GameState_classifyMove(state, move, &captured);
+
+    if (flags & GAMESTATE_MOVE_EXTRA_TURN) return MOVE_WEIGHT_EXTRA_TURN;
+    if (flags & GAMESTATE_MOVE_CAPTURE) return MOVE_WEIGHT_CAPTURE + captured;
+    return MOVE_WEIGHT_QUIET;
+}
+
+/**
+ * Add the children of a node, unless another thread is already doing so or
+ * the tree is full.
+ *
+ * @return Whether the node is expanded
+ */
+static bool expand(MCTS mcts, MCTSNode* node, GameState state) {
+    uint8_t expected = NODE_LEAF;
+    if (atomic_load_explicit(&mcts->full, memory_order_relaxed)) return false;
+    if (!atomic_compare_exchange_strong(&node->expansion, &expected, NODE_EXPANDING)) return false;
+
+    MoveList moves;
+    const int count = GameState_generateMoves(state, &moves);
+    const size_t first = atomic_fetch_add(&mcts->used, (size_t)count);
+
+    if (first + count > mcts->capacity) {
+        atomic_store(&mcts->full, true);
+        atomic_store_explicit(&node->expansion, NODE_LEAF, memory_order_release);
+        return false;
+    }
+
+    // The priors are the normalized move weights.
+    int weights[GAMESTATE_MAX_MOVES];
+    int total = 0;
+
+    for (int i = 0; i < count; i++) {
+        weights[i] = moveWeight(state, moves.moves[i]);
+        total += weights[i];
+    }
+
+    for (int i = 0; i < count; i++) {
+        MCTSNode* const child = &mcts->nodes[first + i];
+        atomic_init(&child->reward, 0);
+        atomic_init(&child->visits, 0);
+        atomic_init(&child->virtualLoss, 0);
+        atomic_init(&child->expansion, NODE_LEAF);
+        child->firstChild = 0;
+        child->childCount = 0;
+        child->move = (int8_t)moves.moves[i];
+        child->mover = (uint8_t)GameState_getCurrentTurn(state);
+        child->prior = (float)weights[i] / (float)total;
+    }
+
+    node->firstChild = (uint32_t)first;
+    node->childCount = (uint8_t)count;
+    atomic_store_explicit(&node->expansion, NODE_EXPANDED, memory_order_release);
+    return true;
+}
+
+/**
+ * Pick the child of an expanded node with the highest PUCT score. Playouts in
+ * progress count as losses for the nodes on their paths (virtual loss).
+ */
+static uint32_t selectChild(MCTS mcts, const MCTSNode* node) {
+    const double parentVisits = (double)atomic_load_explicit(&node->visits, memory_order_relaxed)
+        + atomic_load_explicit(&node->virtualLoss, memory_order_relaxed);
+    const double exploration = MCTS_C_PUCT * sqrt(parentVisits + 1);
+
+    uint32_t best = node->firstChild;
+    double bestScore = -INFINITY;
+
+    for (uint32_t i = node->firstChild; i < node->firstChild + node->childCount; i++) {
+        const MCTSNode* const child = &mcts->nodes[i];
+        const double visits = (double)atomic_load_explicit(&child->visits, memory_order_relaxed)
+            + atomic_load_explicit(&child->virtualLoss, memory_order_relaxed);
+
+        // Unvisited children are assumed to be even.
+        const double value = visits > 0
+            ? (double)atomic_load_explicit(&child->reward, memory_order_relaxed) / (2 * visits)
+            : 0.5;
+        const double score = value + exploration * child->prior / (1 + visits);
+
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Play random moves on a state until the game ends, each chosen with a
+ * probability in proportion to its weight.
+ *
+ * @return The winner (0 or 1), -1 for a draw, or -2 if time ran out first
+ */
+static int playout(MCTSWorker* worker, GameState state) {
+    MoveList moves;
+    GameStateUndo undo;
+
+    // The timer is polled even when the tree policy reached the end of the
+    // game, so a search of a decided position still stops.
+    for (;;) {
+        if (Timer_poll(worker->timer)) return -2;
+        if (GameState_isTerminal(state)) break;
+
+        const int count = GameState_generateMoves(state, &moves);
+        int weights[GAMESTATE_MAX_MOVES];
+        int total = 0;
+
+        for (int i = 0; i < count; i++) {
+            weights[i] = moveWeight(state, moves.moves[i]);
+            total += weights[i];
+        }
+
+        int pick = (int)(nextRandom(worker) % (uint64_t)total);
+        int i = 0;
+        while (pick >= weights[i]) pick -= weights[i++];
+
+        GameState_makeMove(state, moves.moves[i], &undo);
+    }
+
+    const int score0 = GameState_getScore(state, 0);
+    const int score1 = GameState_getScore(state, 1);
+    return score0 > score1 ? 0 : score1 > score0 ? 1 : -1;
+}
+
+/**
+ * Run playouts until time runs out, the playout budget is used up, or another
+ * worker stops the search.
+ */
+static void* searchWorker(void* arg) {
+    MCTSWorker* const worker = (MCTSWorker*)arg;
+    MCTS const mcts = worker->mcts;
+    uint32_t path[MCTS_MAX_PATH];
+
+    while (!atomic_load_explicit(&mcts->stop, memory_order_relaxed)) {
+        if (mcts->maxPlayouts > 0 && atomic_fetch_add(&mcts->started, 1) >= mcts->maxPlayouts) break;
+
+        struct GameState state = mcts->root;
+        GameStateUndo undo;
+        int length = 0;
+        uint32_t index = 0;
+        path[length++] = index;
+
+        // Walk down the tree, expanding the first node that has been visited before.
+        while (length < MCTS_MAX_PATH && !GameState_isTerminal(&state)) {
+            MCTSNode* const node = &mcts->nodes[index];
+
+            if (atomic_load_explicit(&node->expansion, memory_order_acquire) != NODE_EXPANDED) {
+                const bool visited = index == 0 || atomic_load_explicit(&node->visits, memory_order_relaxed) > 0;
+                if (!visited || !expand(mcts, node, &state)) break;
+            }
+
+            index = selectChild(mcts, node);
+            atomic_fetch_add_explicit(&mcts->nodes[index].virtualLoss, 1, memory_order_relaxed);
+            GameState_makeMove(&state, mcts->nodes[index].move, &undo);
+            path[length++] = index;
+        }
+
+        if (length - 1 > worker->depth) worker->depth = length - 1;
+        const int winner = playout(worker, &state);
+
+        // Take back the virtual losses, and count the result if the playout finished.
+        for (int i = 0; i < length; i++) {
+            MCTSNode* const node = &mcts->nodes[path[i]];
+            if (i > 0) atomic_fetch_sub_explicit(&node->virtualLoss, 1, memory_order_relaxed);
+            if (winner == -2) continue;
+
+            const uint64_t reward = winner == -1 ? 1 : winner == node->mover ? 2 : 0;
+            atomic_fetch_add_explicit(&node->reward, reward, memory_order_relaxed);
+            atomic_fetch_add_explicit(&node->visits, 1, memory_order_relaxed);
+        }
+
+        if (winner == -2) {
+            atomic_store(&mcts->stop, true);
+            break;
+        }
+
+        worker->playouts++;
+    }
+
+    return NULL;
+}
+
+/**
+ * Make sure a context has at least a given number of workers.
+ */
+static bool ensureWorkers(MCTS mcts, const int count) {
+    if (count <= mcts->workerCount) return true;
+
+    MCTSWorker* const workers = (MCTSWorker*)realloc(mcts->workers, sizeof(MCTSWorker) * count);
+    if (workers == NULL) return false;
+    mcts->workers = workers;
+
+    pthread_t* const threads = (pthread_t*)realloc(mcts->threads, sizeof(pthread_t) * count);
+    if (threads == NULL) return false;
+    mcts->threads = threads;
+
+    while (mcts->workerCount < count) {
+        MCTSWorker* const worker = &mcts->workers[mcts->workerCount];
+        worker->mcts = mcts;
+        worker->timer = new_Timer();
+        if (worker->timer == NULL) return false;
+        worker->random = 0x9e3779b97f4a7c15ULL * (uint64_t)(mcts->workerCount + 1);
+        mcts->workerCount++;
+    }
+
+    return true;
+}
+
+/**
+ * Returns the context used by the context-free wrappers, creating it if needed.
+ */
+static MCTS getDefaultMCTS() {
+    if (defaultMCTS == NULL) defaultMCTS = new_MCTS(MCTS_DEFAULT_NODES);
+    return defaultMCTS;
+}
+
+
+MCTS new_MCTS(const size_t nodes) {
+    if (nodes < 1 || nodes > UINT32_MAX) return NULL;
+
+    struct MCTS* const newMCTS = (MCTS)calloc(1, sizeof(struct MCTS));
+    if (newMCTS == NULL) return NULL;
+
+    newMCTS->nodes = (MCTSNode*)malloc(sizeof(MCTSNode) * nodes);
+    if (newMCTS->nodes == NULL) {
+        free(newMCTS);
+        return NULL;
+    }
+
+    newMCTS->capacity = nodes;
+    atomic_init(&newMCTS->used, 0);
+    atomic_init(&newMCTS->full, false);
+    atomic_init(&newMCTS->started, 0);
+    atomic_init(&newMCTS->stop, false);
+
+    return newMCTS;
+}
+
+void MCTS_free(MCTS mcts) {
+    if (mcts == NULL) return;
+
+    for (int i = 0; i < mcts->workerCount; i++) Timer_free(mcts->workers[i].timer);
+    free(mcts->workers);
+    free(mcts->threads);
+    free(mcts->nodes);
+    free(mcts);
+}
+
+int MCTS_search(MCTS mcts, GameState state, const time_t timeLimit, const size_t maxPlayouts, int threads) {
+    if (mcts == NULL || state == NULL || GameState_isTerminal(state)) return -2;
+    if (timeLimit <= 0 && maxPlayouts == 0) return -2;
+
+    if (threads < 1) threads = 1;
+    if (!ensureWorkers(mcts, threads)) threads = mcts->workerCount;
+    if (threads < 1) return -2;
+
+    // Start a new tree, with only the root.
+    MCTSNode* const root = &mcts->nodes[0];
+    atomic_init(&root->reward, 0);
+    atomic_init(&root->visits, 0);
+    atomic_init(&root->virtualLoss, 0);
+    atomic_init(&root->expansion, NODE_LEAF);
+    root->childCount = 0;
+    root->move = -2;
+    root->mover = (uint8_t)(GameState_getCurrentTurn(state) == 0 ? 1 : 0);
+
+    mcts->root = *state;
+    mcts->timeLimit = timeLimit;
+    mcts->maxPlayouts = maxPlayouts;
+    atomic_store(&mcts->used, 1);
+    atomic_store(&mcts->full, false);
+    atomic_store(&mcts->started, 0);
+    atomic_store(&mcts->stop, false);
+
+    for (int i = 0; i < mcts->workerCount; i++) {
+        Timer_start(mcts->workers[i].timer, 0, timeLimit);
+        mcts->workers[i].playouts = 0;
+        mcts->workers[i].depth = 0;
+    }
+
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&mcts->threads[started], NULL, searchWorker, &mcts->workers[i]) != 0) break;
+        started++;
+    }
+
+    searchWorker(&mcts->workers[0]);
+    atomic_store(&mcts->stop, true);
+    for (int i = 0; i < started; i++) pthread_join(mcts->threads[i], NULL);
+    mcts->elapsed = Timer_getElapsed(mcts->workers[0].timer);
+
+    // Play the most visited move (the first valid move if there was no time to expand the root).
+    if (atomic_load(&root->expansion) != NODE_EXPANDED) {
+        MoveList moves;
+        GameState_generateMoves(state, &moves);
+        mcts->winRate = 0.5;
+        return moves.moves[0];
+    }
+
+    const MCTSNode* best = &mcts->nodes[root->firstChild];
+    for (uint32_t i = root->firstChild; i < root->firstChild + root->childCount; i++) {
+        if (atomic_load(&mcts->nodes[i].visits) > atomic_load(&best->visits)) best = &mcts->nodes[i];
+    }
+
+    const uint32_t visits = atomic_load(&best->visits);
+    mcts->winRate = visits > 0 ? (double)atomic_load(&best->reward) / (2.0 * visits) : 0.5;
+    return best->move;
+}
+
+void MCTS_getStats(MCTS mcts, MCTSStats* stats) {
+    if (stats == NULL) return;
+    *stats = (MCTSStats){0};
+    if (mcts == NULL) return;
+
+    for (int i = 0; i < mcts->workerCount; i++) {
+        stats->playouts += mcts->workers[i].playouts;
+        if (mcts->workers[i].depth > stats->depth) stats->depth = mcts->workers[i].depth;
+    }
+
+    const size_t used = atomic_load(&mcts->used);
+    stats->nodes = used < mcts->capacity ? used : mcts->capacity;
+    stats->full = atomic_load(&mcts->full);
+    stats->winRate = mcts->winRate;
+    stats->time = mcts->elapsed;
+}
+
+
+int mctsSearch(GameState state, const time_t timeLimit, const size_t maxPlayouts) {
+    return MCTS_search(getDefaultMCTS(), state, timeLimit, maxPlayouts, 1);
+}
+
+int mctsSearchParallel(GameState state, const time_t timeLimit, const size_t maxPlayouts, const int threads) {
+    return MCTS_search(getDefaultMCTS(), state, timeLimit, maxPlayouts, threads);
+}
+
+void mctsGetStats(MCTSStats* stats) {
+    MCTS_getStats(defaultMCTS, stats);
+}
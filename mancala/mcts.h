@@ -0,0 +1,102 @@
+/*
+ * project:  Mancalamax
+ * file:     mcts.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef MCTS_H
+#define MCTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include "state.h"
+
+/**
+ * The default number of tree nodes of an MCTS context (32 bytes each).
+ */
+#define MCTS_DEFAULT_NODES ((size_t)1 << 20)
+
+/**
+ * Statistics of an MCTS search, filled in on request by MCTS_getStats.
+ * Counts include the helper threads.
+ */
+typedef struct MCTSStats {
+    size_t playouts;   // simulated games
+    size_t nodes;      // tree nodes in use
+    bool full;         // whether the tree ran out of nodes
+    int depth;         // deepest node reached by the tree policy
+    double winRate;    // results of the chosen move, for the player to move (draws count half)
+    double time;       // total time (in ms)
+} MCTSStats;
+
+/**
+ * A second engine, for positions where alpha-beta cannot search deep enough
+ * to see anything but the score difference (e.g. large GameState_initCustom
+ * variants): Monte Carlo tree search.
+ *
+ * Each playout walks down the tree with PUCT (the priors favour extra turns
+ * and captures), adds the children of the node it stops at, plays random moves
+ * to the end of the game, and counts the result for every node on its path.
+ * The move played most often at the root is chosen.
+ *
+ * The tree is a single array of nodes, allocated when the context is created;
+ * a node's children are contiguous. Random games are played on a copy of the
+ * state on the stack, so playouts do not allocate. Several threads can search
+ * one tree: a thread counts a virtual loss for every node on its path until its
+ * playout ends, which steers the others elsewhere.
+ */
+typedef struct MCTS* MCTS;
+
+/**
+ * Create a new MCTS context.
+ *
+ * @param nodes The number of tree nodes to allocate (at least 1)
+ * @return A pointer to the new MCTS context, or NULL if allocation failed
+ */
+extern MCTS new_MCTS(size_t nodes);
+
+/**
+ * Free the memory used by an MCTS context, including its tree.
+ */
+extern void MCTS_free(MCTS mcts);
+
+/**
+ * Same as mctsSearchParallel, using the given context.
+ */
+extern int MCTS_search(MCTS mcts, GameState state, time_t timeLimit, size_t maxPlayouts, int threads);
+
+/**
+ * Fill in the statistics of the most recent search on a context.
+ */
+extern void MCTS_getStats(MCTS mcts, MCTSStats* stats);
+
+/**
+ * Find the best move with Monte Carlo tree search.
+ *
+ * @param state The state to search
+ * @param timeLimit The maximum amount of time (in ms) to spend searching (0 for no limit)
+ * @param maxPlayouts The maximum number of playouts (0 for no limit)
+ * @return The most played move, or -2 if the game is over or neither limit was set
+ */
+extern int mctsSearch(GameState state, time_t timeLimit, size_t maxPlayouts);
+
+/**
+ * Same as mctsSearch, but searches one shared tree with several threads.
+ *
+ * @param state The state to search
+ * @param timeLimit The maximum amount of time (in ms) to spend searching (0 for no limit)
+ * @param maxPlayouts The maximum number of playouts over all threads (0 for no limit)
+ * @param threads The total number of search threads, including the calling thread
+ * @return The most played move, or -2 if the game is over or neither limit was set
+ */
+extern int mctsSearchParallel(GameState state, time_t timeLimit, size_t maxPlayouts, int threads);
+
+/**
+ * Fill in the statistics of the most recent search.
+ */
+extern void mctsGetStats(MCTSStats* stats);
+
+
+#endif //MCTS_H
@@ -2,38 +2,187 @@
  * project:  Mancalamax
  * file:     minimax.c
  * author:   Ethan Mentzer
- * modified: 2025-03-08
+ * modified: 2026-10-16
  */
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdalign.h>
+#include <string.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "minimax.h"
 #include "state.h"
-#include "../utils/LinkedList.h"
+#include "ttable.h"
+#include "timer.h"
+#include "endgame.h"
+#include "book.h"
+#include "evalcache.h"
+#include "nnue.h"
+#include "../utils/Arena.h"
 
 
-// Keep track of start time / time limits / heuristic.
-static time_t start, limit;
-static Heuristic h;
+// Plies that have killer move slots (deeper plies go without).
+#define KILLER_PLIES 128
 
-// Declare static functions.
-static void minValue(
-    double* util,
-    int* bestMove,
-    GameState state,
-    double alpha,
-    double beta,
-    int optimizeFor,
-    int depth);
+// Move ordering scores. Quiet moves are ordered by their history score, which stays below these.
+#define ORDER_TABLE_MOVE 1e12
+#define ORDER_EXTRA_TURN 1e11
+#define ORDER_CAPTURE 1e10
+#define ORDER_KILLER 1e9
+
+// Initial half-width of the aspiration window around the previous iteration's score,
+// and the number of times it is widened before falling back to a full window.
+#define ASPIRATION_WINDOW 2.0
+#define ASPIRATION_RETRIES 3
+
+// Lanes of a ChildBatch: at least GAMESTATE_MAX_MOVES, rounded up to a multiple
+// of 4 so scoreBatch works on whole SSE2 vectors.
+#define BATCH_LANES 24
+
+/**
+ * Per-ply scratch space for the search (one frame per level of the tree).
+ */
+typedef struct SearchFrame {
+    MoveList moves;
+    GameStateUndo undo;
+} SearchFrame;
+
+/**
+ * The children of a frontier node (one ply above the horizon), in
+ * structure-of-arrays form. Every child is a leaf, so only what its value
+ * needs is kept. Lanes past size hold stale values, which are computed and ignored.
+ */
+typedef struct ChildBatch {
+    int size;
+    int own[BATCH_LANES];         // the root player's store
+    int other[BATCH_LANES];       // the other player's store
+    double extra[BATCH_LANES];    // added to the score difference (endgame value, or custom heuristic)
+    double values[BATCH_LANES];   // values for the side to move at the frontier node
+
+    // Children waiting for a batch heuristic, and their lanes.
+    struct GameState states[BATCH_LANES];
+    int lanes[BATCH_LANES];
+} ChildBatch;
+
+/**
+ * Everything a search needs, so that independent searches can run at the
+ * same time (e.g. on different threads) with separate contexts.
+ */
+struct SearchContext {
+    // Start time / time manager / heuristic of the current search, and the
+    // soft time limit of future searches.
+    time_t start;
+    Timer timer;
+    time_t softLimit;
+    Heuristic h;
+
+    // Transposition table (shared with helper contexts), and whether the current search ran out of time.
+    size_t tableEntries;
+    TTable table;
+    bool ownsTable;
+    bool timeUp;
+
+    // Whether the table is kept between searches, and the heuristic, network
+    // and root player its entries were computed for (-1 when it holds nothing).
+    // Searches that keep it also keep the move ordering of the previous search,
+    // whose root was at game ply sessionPly.
+    bool keepTable;
+    Heuristic tableHeuristic;
+    Nnue tableNnue;
+    int tablePerspective;
+    int sessionPly;
+
+    // Endgame database probed for exact values, opening book consulted before
+    // searching, and cache of custom heuristic values (none owned by the context).
+    Endgame endgame;
+    Book book;
+    EvalCache evalCache;
+
+    // Batch version of a heuristic, used when a search's heuristic is batchFor.
+    Heuristic batchFor;
+    BatchHeuristic batchHeuristic;
+
+    // Network searches with nnueHeuristic evaluate with (NULL for the default
+    // network), the one the current search uses (NULL when the heuristic is
+    // another), and its accumulator, kept up to date with the last leaf evaluated.
+    Nnue nnue;
+    Nnue activeNnue;
+    NnueAccumulator nnueAccumulator;
 
-static void maxValue(
+    // Stop flag checked at every node (the clock is only polled every TIMER_POLL_INTERVAL nodes).
+    // It is the context's own flag, a caller's flag, or for helpers, their main context's own flag.
+    atomic_bool stop;
+    atomic_bool* stopFlag;
+
+    // Called after every completed iteration of the main context.
+    SearchCallback callback;
+    void* callbackData;
+
+    // Helper contexts for parallel searches, and the arguments of the current search.
+    SearchContext* helpers;
+    pthread_t* helperThreads;
+    int helperCount;
+    int helpersUsed;  // helpers that took part in the last search
+    GameState root;
+    int firstDepth;
+    double firstScore;
+    int maxDepth;
+
+    // Scratch memory, reset after every iteration, and the frames of the current iteration.
+    Arena arena;
+    SearchFrame* frames;
+    int iterationDepth;
+
+    // The player the heuristic evaluates for (the player to move at the root).
+    int perspective;
+
+    // Move ordering: best root move of the previous iteration, killer moves per ply,
+    // and history scores per player and pit (index 0 is the "PIE" move).
+    int pvMove;
+    int killers[KILLER_PLIES][2];
+    double history[2][GAMESTATE_MAX_PITS + 1];
+
+    // Children of the frontier node being searched.
+    ChildBatch batch;
+
+    // Statistics for the current search, and the seed for random fallback moves.
+    // Iterations are kept in a ring of the most recent SEARCHSTATS_MAX_ITERATIONS.
+    size_t nodes;
+    size_t leaves;
+    size_t heuristicCalls;
+    size_t evalCacheHits;
+    size_t cutoffs;
+    size_t cutoffsAt[GAMESTATE_MAX_MOVES];
+    size_t tableHits;
+    size_t tableOverwrites;
+    int completedDepth;
+    double score;
+    bool aborted;
+    double elapsed;
+    SearchIteration iterations[SEARCHSTATS_MAX_ITERATIONS];
+    int iterationCount;
+    unsigned int seed;
+};
+
+// Context used by the context-free wrappers (minimaxIterDep, minimaxAlphaBeta, ...).
+static SearchContext defaultContext = NULL;
+static size_t defaultTableEntries = MINIMAX_DEFAULT_TABLE_ENTRIES;
+
+// Declare static functions.
+static void negamax(
+    SearchContext ctx,
     double* util,
     int* bestMove,
     GameState state,
     double alpha,
     double beta,
-    int optimizeFor,
     int depth);
 
 /**
@@ -60,6 +209,46 @@ static double heuristic(GameState state, const int player) {
         return GameState_getScore(state, 1) - GameState_getScore(state, 0);
 }
 
+/**
+ * Whether a search's leaf values go through its evaluation cache: only those of
+ * custom heuristics do. The default heuristic is cheaper than a probe, and a
+ * network is evaluated incrementally (or, without one, nnueHeuristic is as
+ * cheap as the default heuristic).
+ */
+static bool usesEvalCache(SearchContext ctx) {
+    return ctx->evalCache != NULL && ctx->h != heuristic && ctx->h != nnueHeuristic;
+}
+
+/**
+ * Evaluate a leaf with the context's heuristic, for the root player. Custom
+ * heuristics go through the evaluation cache, if there is one. A network evaluates from the accumulator
+ * of the previous leaf, which is usually a sibling or cousin, so only the few
+ * pits the moves in between changed are updated.
+ */
+static double evaluate(SearchContext ctx, GameState state) {
+    if (ctx->activeNnue != NULL) {
+        ctx->heuristicCalls++;
+        Nnue_update(ctx->activeNnue, &ctx->nnueAccumulator, state);
+        return Nnue_evaluate(ctx->activeNnue, &ctx->nnueAccumulator, state, ctx->perspective);
+    }
+
+    if (!usesEvalCache(ctx)) {
+        ctx->heuristicCalls++;
+        return ctx->h(state, ctx->perspective);
+    }
+
+    double value;
+    if (EvalCache_probe(ctx->evalCache, state, ctx->perspective, &value)) {
+        ctx->evalCacheHits++;
+        return value;
+    }
+
+    ctx->heuristicCalls++;
+    value = ctx->h(state, ctx->perspective);
+    EvalCache_store(ctx->evalCache, state, ctx->perspective, value);
+    return value;
+}
+
 
 /**
  * Helper function to convert a timespec struct to milliseconds.
@@ -68,251 +257,1069 @@ static time_t timespecToMs(const struct timespec ts) {
     return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
+/**
+ * Forget the move ordering information of a previous search.
+ */
+static void resetOrdering(SearchContext ctx) {
+    ctx->pvMove = -2;
 
-int minimaxIterDep(GameState state, const time_t timeLimit, const int maxDepth, Heuristic customHeuristic) {
-    if (state == NULL) return -2;
+    for (int ply = 0; ply < KILLER_PLIES; ply++) {
+        ctx->killers[ply][0] = -2;
+        ctx->killers[ply][1] = -2;
+    }
+
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i <= GAMESTATE_MAX_PITS; i++) ctx->history[player][i] = 0;
+    }
+}
+
+/**
+ * Carry the move ordering information of a previous search over to a search
+ * of a position a number of plies later. History scores are halved, so what
+ * the new search learns soon outweighs them, and killers move up to the plies
+ * they now belong to.
+ */
+static void ageOrdering(SearchContext ctx, const int plies) {
+    if (plies < 0 || plies >= KILLER_PLIES) {
+        resetOrdering(ctx);
+        return;
+    }
+
+    ctx->pvMove = -2;
+
+    for (int ply = 0; ply < KILLER_PLIES; ply++) {
+        const bool carried = ply + plies < KILLER_PLIES;
+        ctx->killers[ply][0] = carried ? ctx->killers[ply + plies][0] : -2;
+        ctx->killers[ply][1] = carried ? ctx->killers[ply + plies][1] : -2;
+    }
+
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i <= GAMESTATE_MAX_PITS; i++) ctx->history[player][i] /= 2;
+    }
+}
+
+/**
+ * Sort the moves of a state so the most promising are searched first: the
+ * table (or previous iteration's) move, then extra turns, then captures by
+ * size, then killer moves, then the remaining quiet moves by history score.
+ * Ties keep the move generation order.
+ */
+static void orderMoves(SearchContext ctx, GameState state, MoveList* moves, const int firstMove, const int ply) {
+    const int player = GameState_getCurrentTurn(state);
+    double scores[GAMESTATE_MAX_MOVES];
+
+    for (int i = 0; i < moves->size; i++) {
+        const int move = moves->moves[i];
+        int captured;
+        const int flags = GameState_classifyMove(state, move, &captured);
+
+        if (move == firstMove)
+            scores[i] = ORDER_TABLE_MOVE;
+        else if (flags & GAMESTATE_MOVE_EXTRA_TURN)
+            scores[i] = ORDER_EXTRA_TURN;
+        else if (flags & GAMESTATE_MOVE_CAPTURE)
+            scores[i] = ORDER_CAPTURE + captured;
+        else if (ply < KILLER_PLIES && (move == ctx->killers[ply][0] || move == ctx->killers[ply][1]))
+            scores[i] = ORDER_KILLER + (move == ctx->killers[ply][0] ? 1 : 0);
+        else
+            scores[i] = ctx->history[player][move == -1 ? 0 : move];
+    }
 
+    // Insertion sort (lists are short), keeping equal scores in their original order.
+    for (int i = 1; i < moves->size; i++) {
+        const int move = moves->moves[i];
+        const double score = scores[i];
+        int j = i - 1;
+
+        while (j >= 0 && scores[j] < score) {
+            moves->moves[j + 1] = moves->moves[j];
+            scores[j + 1] = scores[j];
+            j--;
+        }
+
+        moves->moves[j + 1] = move;
+        scores[j + 1] = score;
+    }
+}
+
+/**
+ * Record a move that caused a cutoff. Quiet moves become killers for their
+ * ply, and gain history in proportion to the depth of the subtree they cut.
+ */
+static void recordCutoff(SearchContext ctx, GameState state, const int move, const int index, const int ply, const int depth) {
+    ctx->cutoffs++;
+    ctx->cutoffsAt[index]++;
+
+    if (GameState_classifyMove(state, move, NULL) != 0) return;
+
+    if (ply < KILLER_PLIES && ctx->killers[ply][0] != move) {
+        ctx->killers[ply][1] = ctx->killers[ply][0];
+        ctx->killers[ply][0] = move;
+    }
+
+    ctx->history[GameState_getCurrentTurn(state)][move == -1 ? 0 : move] += (double)depth * depth;
+}
+
+/**
+ * Forget the statistics of a previous search.
+ */
+static void resetStats(SearchContext ctx) {
+    ctx->nodes = 0;
+    ctx->leaves = 0;
+    ctx->heuristicCalls = 0;
+    ctx->evalCacheHits = 0;
+    ctx->cutoffs = 0;
+    for (int i = 0; i < GAMESTATE_MAX_MOVES; i++) ctx->cutoffsAt[i] = 0;
+    ctx->tableHits = 0;
+    ctx->tableOverwrites = 0;
+    ctx->completedDepth = 0;
+    ctx->score = 0;
+    ctx->aborted = false;
+    ctx->elapsed = 0;
+    ctx->iterationCount = 0;
+}
+
+/**
+ * Prepare a context for a new search of a state. Results from earlier searches
+ * may have been computed for another player, heuristic or network, so the
+ * table is cleared unless it is kept and they match. A kept table is aged
+ * instead, and the move ordering carried over with it.
+ */
+static void beginSearch(SearchContext ctx, GameState state, const time_t timeLimit, Heuristic customHeuristic) {
     struct timespec timer;
     clock_gettime(CLOCK_MONOTONIC, &timer);
 
     // Set start and end times.
-    start = timespecToMs(timer);
-    limit = timeLimit;
-    time_t now = start;
+    ctx->start = timespecToMs(timer);
+    Timer_start(ctx->timer, ctx->softLimit, timeLimit);
+
+    // Set heuristic, and the network behind it (if any), whose accumulator starts empty.
+    ctx->h = customHeuristic == NULL ? heuristic : customHeuristic;
+    ctx->activeNnue = ctx->h != nnueHeuristic ? NULL : ctx->nnue != NULL ? ctx->nnue : nnueGetDefault();
+    ctx->nnueAccumulator.pits = 0;
 
-    // Set heuristic.
-    h = customHeuristic == NULL ? heuristic : customHeuristic;
+    if (ctx->table == NULL && ctx->tableEntries > 0) {
+        ctx->table = new_TTable(ctx->tableEntries);
+        ctx->tablePerspective = -1;
+    }
+
+    const int perspective = GameState_getCurrentTurn(state);
+    if (!ctx->keepTable || ctx->tableHeuristic != ctx->h || ctx->tableNnue != ctx->activeNnue
+        || ctx->tablePerspective != perspective) {
+        TTable_clear(ctx->table);
+        ctx->tableHeuristic = ctx->h;
+        ctx->tableNnue = ctx->activeNnue;
+        ctx->tablePerspective = perspective;
+        resetOrdering(ctx);
+    } else {
+        TTable_age(ctx->table);
+        ageOrdering(ctx, state->ply - ctx->sessionPly);
+    }
+    ctx->sessionPly = state->ply;
 
-    LinkedList bestMoves = new_LinkedList();
-    int depth = 2;
+    // Cached values only hold for the heuristic that computed them; the cache
+    // clears itself when it is used with another one.
+    if (usesEvalCache(ctx)) EvalCache_setHeuristic(ctx->evalCache, ctx->h);
+
+    ctx->timeUp = false;
+    atomic_store(&ctx->stop, false);
+
+    if (ctx->arena == NULL) ctx->arena = new_Arena(0);
+    Arena_reset(ctx->arena);
+    Arena_resetStats(ctx->arena);
+
+    ctx->helpersUsed = 0;
+    resetStats(ctx);
+    ctx->seed = (unsigned int)ctx->start;
+}
+
+/**
+ * Prepare a helper context to join its main context's search. The helper
+ * shares the main context's table, heuristic and stop flag. It has no time
+ * limit of its own: the main context stops it.
+ */
+static void beginHelperSearch(SearchContext helper, SearchContext ctx) {
+    helper->start = ctx->start;
+    Timer_start(helper->timer, 0, 0);
+    helper->h = ctx->h;
+    helper->table = ctx->table;
+    helper->endgame = ctx->endgame;
+    helper->batchFor = ctx->batchFor;
+    helper->batchHeuristic = ctx->batchHeuristic;
+    helper->evalCache = ctx->evalCache;
+    helper->activeNnue = ctx->activeNnue;
+    helper->nnueAccumulator.pits = 0;
+    helper->timeUp = false;
+    helper->stopFlag = &ctx->stop;
+
+    if (helper->arena == NULL) helper->arena = new_Arena(0);
+    Arena_reset(helper->arena);
+    Arena_resetStats(helper->arena);
+
+    resetOrdering(helper);
+    resetStats(helper);
+}
+
+/**
+ * Allocate the scratch memory for one iteration to a given depth, and
+ * return the iteration's private copy of the root state.
+ */
+static GameState beginIteration(SearchContext ctx, GameState state, const int depth) {
+    ctx->frames = (SearchFrame*)Arena_alloc(ctx->arena, sizeof(SearchFrame) * (depth + 1));
+    ctx->iterationDepth = depth;
+    ctx->perspective = GameState_getCurrentTurn(state);
+    return GameState_copyIn(ctx->arena, state);
+}
+
+/**
+ * Release the scratch memory of the current iteration.
+ */
+static void endIteration(SearchContext ctx) {
+    ctx->frames = NULL;
+    Arena_reset(ctx->arena);
+}
+
+/**
+ * Search the root to a given depth with an aspiration window around the
+ * previous iteration's score (or a full window if there is none). When the
+ * result falls outside the window, the window is widened on that side and
+ * the root is searched again.
+ *
+ * If time runs out, bestMove is the best root move proven better than the
+ * previous iteration's, or -2 if there is none.
+ */
+static void searchRoot(
+    SearchContext ctx,
+    double* util,
+    int* bestMove,
+    GameState root,
+    const int depth,
+    const double previous)
+{
+    if (isinf(previous)) {
+        negamax(ctx, util, bestMove, root, -INFINITY, INFINITY, depth);
+        return;
+    }
+
+    double lowWidth = ASPIRATION_WINDOW;
+    double highWidth = ASPIRATION_WINDOW;
+    int failHighMove = -2;
+
+    for (int attempt = 0; ; attempt++) {
+        const double alpha = attempt > ASPIRATION_RETRIES ? -INFINITY : previous - lowWidth;
+        const double beta = attempt > ASPIRATION_RETRIES ? INFINITY : previous + highWidth;
+
+        negamax(ctx, util, bestMove, root, alpha, beta, depth);
+
+        // A move that failed high beat the previous score, so it is still
+        // worth playing if the re-search is cut short.
+        if (ctx->timeUp) {
+            if (*bestMove == -2) *bestMove = failHighMove;
+            return;
+        }
+
+        if (*util <= alpha) {
+            lowWidth = isinf(alpha) ? lowWidth : lowWidth * 4;
+        } else if (*util >= beta) {
+            highWidth = isinf(beta) ? highWidth : highWidth * 4;
+            failHighMove = *bestMove;
+        } else {
+            return;
+        }
+
+        if (isinf(alpha) && isinf(beta)) return;
+    }
+}
+
+/**
+ * Search with iterative deepening from ctx->firstDepth until time runs out, the
+ * search is stopped, or ctx->maxDepth has been reached. A new iteration is only
+ * started if the time manager expects it to finish in time.
+ *
+ * @return The best move of the deepest completed iteration, or of the
+ *         interrupted one if it found a better move (-2 if none)
+ */
+static int iterativeDeepening(SearchContext ctx) {
+    int found = -2;
+    int depth = ctx->firstDepth;
+    double previous = ctx->firstScore;
 
     // Search until time runs out, or until the max depth has been reached.
-    while (now < start + timeLimit && depth <= maxDepth) {
+    while (depth <= ctx->maxDepth && !atomic_load(ctx->stopFlag)) {
+        if (found != -2 && !Timer_canStartIteration(ctx->timer)) break;
+
         double util;
         int bestMove;
-        maxValue(
-            &util, &bestMove,
-            state,
-            -INFINITY, INFINITY,
-            GameState_getCurrentTurn(state),
-            depth);
+        const size_t nodes = ctx->nodes;
+
+        // Each iteration walks a single mutable copy of the state.
+        searchRoot(ctx, &util, &bestMove, beginIteration(ctx, ctx->root, depth), depth, previous);
+        endIteration(ctx);
+
+        if (bestMove != -2) found = bestMove;
+        if (ctx->timeUp) {
+            ctx->aborted = true;
+            break;
+        }
 
-        if (bestMove != -2)
-            LinkedList_prepend(bestMoves, bestMove);
+        ctx->completedDepth = depth;
+        ctx->score = util;
+        ctx->pvMove = bestMove;
+        previous = util;
+        Timer_endIteration(ctx->timer, ctx->nodes - nodes);
 
+        SearchIteration* const iteration = &ctx->iterations[ctx->iterationCount++ % SEARCHSTATS_MAX_ITERATIONS];
+        iteration->depth = depth;
+        iteration->move = bestMove;
+        iteration->score = util;
+        iteration->nodes = ctx->nodes - nodes;
+        iteration->time = Timer_getElapsed(ctx->timer);
+        if (ctx->callback != NULL) ctx->callback(ctx, iteration, ctx->callbackData);
         depth++;
+    }
+
+    return found;
+}
+
+/**
+ * Thread entry point for helper contexts in a parallel search.
+ */
+static void* helperThread(void* arg) {
+    SearchContext helper = (SearchContext)arg;
+    iterativeDeepening(helper);
+    return NULL;
+}
+
+/**
+ * Make sure a context has at least a given number of helper contexts.
+ */
+static bool ensureHelpers(SearchContext ctx, const int count) {
+    if (count <= ctx->helperCount) return true;
+
+    SearchContext* const helpers = (SearchContext*)realloc(ctx->helpers, sizeof(SearchContext) * count);
+    if (helpers == NULL) return false;
+    ctx->helpers = helpers;
 
-        clock_gettime(CLOCK_MONOTONIC, &timer);
-        now = timespecToMs(timer);
+    pthread_t* const helperThreads = (pthread_t*)realloc(ctx->helperThreads, sizeof(pthread_t) * count);
+    if (helperThreads == NULL) return false;
+    ctx->helperThreads = helperThreads;
+
+    while (ctx->helperCount < count) {
+        SearchContext const helper = new_SearchContext(0);
+        if (helper == NULL) return false;
+        helper->ownsTable = false;
+        ctx->helpers[ctx->helperCount++] = helper;
     }
 
-    // Return a random move if nothing found.
-    if (LinkedList_size(bestMoves) < 2) {
-        srand(time(NULL));
-        LinkedList validMoves = GameState_getValidMoves(state);
-        const int randIndex = rand() % LinkedList_size(validMoves);
-        const int result = LinkedList_get(validMoves, randIndex);
-        LinkedList_free(bestMoves);
-        LinkedList_free(validMoves);
-        return result;
+    return true;
+}
+
+/**
+ * Choose the depth of the first iteration. A kept table may already hold a
+ * result for the root, searched as a child of an earlier search's root (or by
+ * pondering); iterations up to its depth would mostly repeat that work, so
+ * deepening starts there, with its score as the aspiration window's center.
+ */
+static void chooseFirstDepth(SearchContext ctx, GameState state, const int maxDepth) {
+    ctx->firstDepth = 2;
+    ctx->firstScore = INFINITY;
+
+    double value;
+    int depth, move;
+    TTBound bound;
+    if (!TTable_probe(ctx->table, GameState_getHash(state), &value, &depth, &bound, &move)) return;
+    if (move == -2 || depth <= ctx->firstDepth) return;
+
+    ctx->firstDepth = depth < maxDepth ? depth : maxDepth;
+    if (bound == TT_EXACT) ctx->firstScore = value;
+}
+
+/**
+ * Pick a random valid move, for when the search could not find one.
+ */
+static int randomMove(SearchContext ctx, GameState state) {
+    MoveList validMoves;
+    if (GameState_generateMoves(state, &validMoves) == 0) return -2;
+
+    return validMoves.moves[rand_r(&ctx->seed) % validMoves.size];
+}
+
+/**
+ * Returns the context used by the context-free wrappers, creating it if needed.
+ */
+static SearchContext getDefaultContext() {
+    if (defaultContext == NULL) defaultContext = new_SearchContext(defaultTableEntries);
+    return defaultContext;
+}
+
+
+SearchContext new_SearchContext(const size_t tableEntries) {
+    struct SearchContext* const newContext = (SearchContext)calloc(1, sizeof(struct SearchContext));
+    if (newContext == NULL) return NULL;
+
+    // The table and arena are allocated by the first search.
+    newContext->tableEntries = tableEntries;
+    newContext->ownsTable = true;
+    newContext->tablePerspective = -1;
+    newContext->h = heuristic;
+
+    newContext->timer = new_Timer();
+    if (newContext->timer == NULL) {
+        free(newContext);
+        return NULL;
     }
 
-    // Always get the last fully completed search depth result.
-    const int result = LinkedList_get(bestMoves, 1);
-    LinkedList_free(bestMoves);
-    return result;
+    atomic_init(&newContext->stop, false);
+    newContext->stopFlag = &newContext->stop;
+
+    return newContext;
 }
 
+void SearchContext_free(SearchContext ctx) {
+    if (ctx == NULL) return;
 
-int minimaxAlphaBeta(GameState state, const int maxDepth, Heuristic customHeuristic) {
-    if (state == NULL) return -2;
+    for (int i = 0; i < ctx->helperCount; i++) SearchContext_free(ctx->helpers[i]);
+    free(ctx->helpers);
+    free(ctx->helperThreads);
+
+    if (ctx->ownsTable) TTable_free(ctx->table);
+    Arena_free(ctx->arena);
+    Timer_free(ctx->timer);
+    free(ctx);
+}
+
+void SearchContext_setTableSize(SearchContext ctx, const size_t entries) {
+    if (ctx == NULL) return;
+
+    TTable_free(ctx->table);
+    ctx->table = NULL;
+    ctx->tableEntries = entries;
+}
+
+size_t SearchContext_getScratchBytes(const int maxDepth) {
+    if (maxDepth < 0) return 0;
+
+    // An iteration takes its frames and a copy of the root from the arena.
+    // When they do not fit in the first block, the arena keeps that block
+    // and adds one for the frames and (at worst) another for the root.
+    const size_t align = alignof(max_align_t);
+    const size_t frames = (sizeof(SearchFrame) * ((size_t)maxDepth + 1) + align - 1) / align * align;
+    const size_t root = (sizeof(struct GameState) + align - 1) / align * align;
+
+    if (frames + root <= ARENA_DEFAULT_BLOCK_SIZE) return ARENA_DEFAULT_BLOCK_SIZE;
+    return 2 * ARENA_DEFAULT_BLOCK_SIZE + frames;
+}
+
+void SearchContext_setEndgame(SearchContext ctx, Endgame db) {
+    if (ctx == NULL) return;
+    ctx->endgame = db;
+}
+
+void SearchContext_setBook(SearchContext ctx, Book book) {
+    if (ctx == NULL) return;
+    ctx->book = book;
+}
+
+void SearchContext_setBatchHeuristic(SearchContext ctx, Heuristic h, BatchHeuristic batch) {
+    if (ctx == NULL) return;
+    ctx->batchFor = batch != NULL ? h : NULL;
+    ctx->batchHeuristic = batch;
+}
+
+void SearchContext_setEvalCache(SearchContext ctx, EvalCache cache) {
+    if (ctx == NULL) return;
+    ctx->evalCache = cache;
+}
+
+void SearchContext_setNnue(SearchContext ctx, Nnue nnue) {
+    if (ctx == NULL) return;
+    ctx->nnue = nnue;
+}
+
+void SearchContext_setCallback(SearchContext ctx, SearchCallback callback, void* data) {
+    if (ctx == NULL) return;
+    ctx->callback = callback;
+    ctx->callbackData = data;
+}
+
+void SearchContext_setStopFlag(SearchContext ctx, atomic_bool* flag) {
+    if (ctx == NULL) return;
+    ctx->stopFlag = flag == NULL ? &ctx->stop : flag;
+}
+
+void SearchContext_setSoftLimit(SearchContext ctx, const time_t softLimit) {
+    if (ctx == NULL) return;
+    ctx->softLimit = softLimit;
+}
+
+void SearchContext_setKeepTable(SearchContext ctx, const bool keep) {
+    if (ctx == NULL) return;
+    ctx->keepTable = keep;
+}
+
+void SearchContext_newGame(SearchContext ctx) {
+    if (ctx == NULL) return;
+
+    // The next search clears the table and ordering when the table holds nothing.
+    ctx->tablePerspective = -1;
+}
+
+int SearchContext_iterDep(
+    SearchContext ctx,
+    GameState state,
+    const time_t timeLimit,
+    const int maxDepth,
+    Heuristic customHeuristic)
+{
+    return SearchContext_iterDepParallel(ctx, state, timeLimit, maxDepth, customHeuristic, 1);
+}
+
+int SearchContext_iterDepParallel(
+    SearchContext ctx,
+    GameState state,
+    const time_t timeLimit,
+    const int maxDepth,
+    Heuristic customHeuristic,
+    int threads)
+{
+    if (ctx == NULL || state == NULL) return -2;
+
+    beginSearch(ctx, state, timeLimit, customHeuristic);
+
+    // Play straight from the opening book when possible.
+    int bookMove;
+    if (Book_probe(ctx->book, state, &bookMove, &ctx->score)) return bookMove;
+
+    ctx->root = state;
+    chooseFirstDepth(ctx, state, maxDepth);
+    ctx->maxDepth = maxDepth;
+
+    // Fall back to fewer threads if helpers cannot be created.
+    if (threads < 1 || ctx->table == NULL) threads = 1;
+    if (!ensureHelpers(ctx, threads - 1)) threads = ctx->helperCount + 1;
+
+    // Start the helpers. Every other helper starts one depth deeper, so the
+    // threads spread out over different iterations and fill the shared table
+    // with results the others can use.
+    int started = 0;
+
+    for (int i = 0; i < threads - 1; i++) {
+        SearchContext const helper = ctx->helpers[i];
+        beginHelperSearch(helper, ctx);
+        helper->root = state;
+        helper->firstDepth = ctx->firstDepth + (i % 2 == 0 ? 1 : 0);
+        helper->firstScore = ctx->firstScore;
+        helper->maxDepth = maxDepth;
+
+        if (pthread_create(&ctx->helperThreads[started], NULL, helperThread, helper) != 0) break;
+        started++;
+    }
+    ctx->helpersUsed = started;
+
+    const int bestMove = iterativeDeepening(ctx);
+
+    // The main thread's result is final, so stop the helpers (which watch
+    // the context's own flag, even when the search uses a caller's flag).
+    atomic_store(&ctx->stop, true);
+    for (int i = 0; i < started; i++) pthread_join(ctx->helperThreads[i], NULL);
+    ctx->elapsed = Timer_getElapsed(ctx->timer);
+
+    // Return a random move if nothing found.
+    if (bestMove == -2) return randomMove(ctx, state);
+
+    return bestMove;
+}
+
+int SearchContext_alphaBeta(
+    SearchContext ctx,
+    GameState state,
+    const int maxDepth,
+    Heuristic customHeuristic)
+{
+    if (ctx == NULL || state == NULL) return -2;
 
     double util;
     int bestMove;
-    start = limit = 0;
-
-    // Set heuristic.
-    h = customHeuristic == NULL ? heuristic : customHeuristic;
+    beginSearch(ctx, state, 0, customHeuristic);
 
-    maxValue(
-        &util, &bestMove,
-        state,
-        -INFINITY, INFINITY,
-        GameState_getCurrentTurn(state),
-        maxDepth);
+    // The search walks a single mutable copy of the state.
+    negamax(ctx, &util, &bestMove, beginIteration(ctx, state, maxDepth), -INFINITY, INFINITY, maxDepth);
+    endIteration(ctx);
+    ctx->firstDepth = maxDepth;
+    ctx->completedDepth = maxDepth;
+    ctx->score = util;
+    ctx->elapsed = Timer_getElapsed(ctx->timer);
 
     // Return a random move if nothing found.
-    if (bestMove == -2) {
-        srand(time(NULL));
-        LinkedList validMoves = GameState_getValidMoves(state);
-        const int randIndex = rand() % LinkedList_size(validMoves);
-        const int result = LinkedList_get(validMoves, randIndex);
-        LinkedList_free(validMoves);
-        return result;
-    }
+    if (bestMove == -2) return randomMove(ctx, state);
 
     return bestMove;
 }
 
+void SearchContext_getTableStats(SearchContext ctx, size_t* hits, size_t* overwrites) {
+    if (ctx == NULL) return;
 
-static void maxValue(
-    double* util,
-    int* bestMove,
+    size_t totalHits = ctx->tableHits;
+    size_t totalOverwrites = ctx->tableOverwrites;
+    for (int i = 0; i < ctx->helpersUsed; i++) {
+        totalHits += ctx->helpers[i]->tableHits;
+        totalOverwrites += ctx->helpers[i]->tableOverwrites;
+    }
+
+    if (hits != NULL) *hits = totalHits;
+    if (overwrites != NULL) *overwrites = totalOverwrites;
+}
+
+void SearchContext_getMemoryStats(SearchContext ctx, size_t* peakBytes, size_t* allocations) {
+    if (ctx == NULL) return;
+    if (peakBytes != NULL) *peakBytes = Arena_getPeakBytes(ctx->arena);
+    if (allocations != NULL) *allocations = Arena_getAllocations(ctx->arena);
+}
+
+size_t SearchContext_getNodes(SearchContext ctx) {
+    if (ctx == NULL) return 0;
+
+    size_t nodes = ctx->nodes;
+    for (int i = 0; i < ctx->helpersUsed; i++) nodes += ctx->helpers[i]->nodes;
+
+    return nodes;
+}
+
+void SearchContext_getCutoffStats(SearchContext ctx, size_t* cutoffs, size_t* firstMoveCutoffs) {
+    if (ctx == NULL) return;
+
+    size_t total = ctx->cutoffs;
+    size_t first = ctx->cutoffsAt[0];
+    for (int i = 0; i < ctx->helpersUsed; i++) {
+        total += ctx->helpers[i]->cutoffs;
+        first += ctx->helpers[i]->cutoffsAt[0];
+    }
+
+    if (cutoffs != NULL) *cutoffs = total;
+    if (firstMoveCutoffs != NULL) *firstMoveCutoffs = first;
+}
+
+int SearchContext_getCompletedDepth(SearchContext ctx) {
+    if (ctx == NULL) return 0;
+    return ctx->completedDepth;
+}
+
+double SearchContext_getScore(SearchContext ctx) {
+    if (ctx == NULL) return 0;
+    return ctx->score;
+}
+
+int SearchContext_getPV(SearchContext ctx, GameState state, int* moves, const int maxMoves) {
+    if (ctx == NULL || state == NULL || moves == NULL || ctx->table == NULL) return 0;
+
+    // Follow the best moves stored in the table from a private copy of the state.
+    struct GameState position = *state;
+    int count = 0;
+
+    while (count < maxMoves && !GameState_isTerminal(&position)) {
+        double value;
+        int depth, move;
+        TTBound bound;
+        if (!TTable_probe(ctx->table, GameState_getHash(&position), &value, &depth, &bound, &move)) break;
+
+        // Entries can be overwritten by other positions (or belong to another search), so check the move.
+        MoveList validMoves;
+        GameState_generateMoves(&position, &validMoves);
+        if (!MoveList_contains(&validMoves, move)) break;
+
+        moves[count++] = move;
+        GameState_moveInto(&position, move, &position);
+    }
+
+    return count;
+}
+
+void SearchContext_getStats(SearchContext ctx, SearchStats* stats) {
+    if (stats == NULL) return;
+    memset(stats, 0, sizeof(SearchStats));
+    if (ctx == NULL) return;
+
+    // Node and cutoff counts include the helper threads.
+    for (int i = -1; i < ctx->helpersUsed; i++) {
+        SearchContext const c = i < 0 ? ctx : ctx->helpers[i];
+        stats->nodes += c->nodes;
+        stats->leaves += c->leaves;
+        stats->heuristicCalls += c->heuristicCalls;
+        stats->evalCacheHits += c->evalCacheHits;
+        stats->cutoffs += c->cutoffs;
+        for (int j = 0; j < GAMESTATE_MAX_MOVES; j++) stats->cutoffsAt[j] += c->cutoffsAt[j];
+    }
+
+    stats->branchingFactor = Timer_getBranchingFactor(ctx->timer);
+    stats->firstDepth = ctx->firstDepth;
+    stats->completedDepth = ctx->completedDepth;
+    stats->score = ctx->score;
+    stats->aborted = ctx->aborted;
+    stats->time = ctx->elapsed;
+
+    // Unroll the ring of iterations, oldest first.
+    const int count = ctx->iterationCount < SEARCHSTATS_MAX_ITERATIONS ? ctx->iterationCount : SEARCHSTATS_MAX_ITERATIONS;
+    for (int i = 0; i < count; i++)
+        stats->iterations[i] = ctx->iterations[(ctx->iterationCount - count + i) % SEARCHSTATS_MAX_ITERATIONS];
+    stats->iterationCount = count;
+}
+
+
+int minimaxIterDep(GameState state, const time_t timeLimit, const int maxDepth, Heuristic customHeuristic) {
+    return SearchContext_iterDep(getDefaultContext(), state, timeLimit, maxDepth, customHeuristic);
+}
+
+int minimaxIterDepParallel(
     GameState state,
-    double alpha,
-    const double beta,
-    const int optimizeFor,
-    int depth)
+    const time_t timeLimit,
+    const int maxDepth,
+    Heuristic customHeuristic,
+    const int threads)
 {
-    // If we are in a terminal state, evaluate utility.
-    if (GameState_isTerminal(state)) {
-        *util = utility(state, optimizeFor);
-        *bestMove = -2;
-        return;
+    return SearchContext_iterDepParallel(getDefaultContext(), state, timeLimit, maxDepth, customHeuristic, threads);
+}
+
+int minimaxAlphaBeta(GameState state, const int maxDepth, Heuristic customHeuristic) {
+    return SearchContext_alphaBeta(getDefaultContext(), state, maxDepth, customHeuristic);
+}
+
+void minimaxSetTableSize(const size_t entries) {
+    defaultTableEntries = entries;
+    SearchContext_setTableSize(defaultContext, entries);
+}
+
+void minimaxSetEndgame(Endgame db) {
+    SearchContext_setEndgame(getDefaultContext(), db);
+}
+
+void minimaxSetBook(Book book) {
+    SearchContext_setBook(getDefaultContext(), book);
+}
+
+void minimaxSetBatchHeuristic(Heuristic h, BatchHeuristic batch) {
+    SearchContext_setBatchHeuristic(getDefaultContext(), h, batch);
+}
+
+void minimaxSetEvalCache(EvalCache cache) {
+    SearchContext_setEvalCache(getDefaultContext(), cache);
+}
+
+void minimaxGetStats(SearchStats* stats) {
+    SearchContext_getStats(defaultContext, stats);
+}
+
+void minimaxGetTableStats(size_t* hits, size_t* overwrites) {
+    if (hits != NULL) *hits = 0;
+    if (overwrites != NULL) *overwrites = 0;
+    SearchContext_getTableStats(defaultContext, hits, overwrites);
+}
+
+void minimaxGetMemoryStats(size_t* peakBytes, size_t* allocations) {
+    if (peakBytes != NULL) *peakBytes = 0;
+    if (allocations != NULL) *allocations = 0;
+    SearchContext_getMemoryStats(defaultContext, peakBytes, allocations);
+}
+
+
+/**
+ * Score a batch of children for the side to move at the frontier node. A child's
+ * value for that side is sign times its value for the root player, whether or not
+ * the turn passes, so the whole batch is one subtract and multiply-add, done four
+ * lanes at a time with SSE2 where it is available.
+ */
+static void scoreBatch(ChildBatch* batch, const double sign) {
+#if defined(__SSE2__)
+    const __m128d scale = _mm_set1_pd(sign);
+
+    for (int i = 0; i < BATCH_LANES; i += 4) {
+        const __m128i own = _mm_loadu_si128((const __m128i*)&batch->own[i]);
+        const __m128i other = _mm_loadu_si128((const __m128i*)&batch->other[i]);
+        const __m128i difference = _mm_sub_epi32(own, other);
+
+        // Widen the low and high pairs of differences to doubles.
+        const __m128d low = _mm_cvtepi32_pd(difference);
+        const __m128d high = _mm_cvtepi32_pd(_mm_shuffle_epi32(difference, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        _mm_storeu_pd(&batch->values[i], _mm_add_pd(_mm_mul_pd(scale, low), _mm_loadu_pd(&batch->extra[i])));
+        _mm_storeu_pd(&batch->values[i + 2], _mm_add_pd(_mm_mul_pd(scale, high), _mm_loadu_pd(&batch->extra[i + 2])));
     }
+#else
+    for (int i = 0; i < BATCH_LANES; i++)
+        batch->values[i] = sign * (double)(batch->own[i] - batch->other[i]) + batch->extra[i];
+#endif
+}
 
-    struct timespec timer;
-    clock_gettime(CLOCK_MONOTONIC, &timer);
-    const time_t now = timespecToMs(timer);
+/**
+ * Expand children [first, last) of a frontier node into the batch, and score the
+ * batch. Children are leaves, so each is counted and classified as negamax would,
+ * but nothing is searched. A custom heuristic with a batch version is called once
+ * for all the children that need it.
+ */
+static void expandFrontier(
+    SearchContext ctx,
+    GameState state,
+    const MoveList* moves,
+    const int first,
+    const int last,
+    const double sign)
+{
+    ChildBatch* const batch = &ctx->batch;
+    const int turn = GameState_getCurrentTurn(state);
+    const int perspective = ctx->perspective;
+    const bool scoreDifference = ctx->h == heuristic;
+    const BatchHeuristic batchHeuristic = ctx->h == ctx->batchFor ? ctx->batchHeuristic : NULL;
+    int pending = 0;
+    GameStateUndo undo;
 
-    // If we have reached artificial limit, use the heuristic.
-    if (depth <= 0 || (limit > 0 && now > start + limit)) {
-        *util = h(state, optimizeFor);
-        *bestMove = -2;
-        return;
+    batch->size = last;
+    ctx->leaves += last - first;
+
+    for (int i = first; i < last; i++) {
+        GameState_makeMove(state, moves->moves[i], &undo);
+        batch->own[i] = GameState_getScore(state, perspective);
+        batch->other[i] = GameState_getScore(state, perspective == 0 ? 1 : 0);
+        batch->extra[i] = 0;
+
+        // Terminal children are worth the score difference alone.
+        if (!GameState_isTerminal(state)) {
+            ctx->nodes++;
+            int endgameValue;
+
+            if (Endgame_probe(ctx->endgame, state, &endgameValue)) {
+                // The database value is for the child's side to move.
+                batch->extra[i] = GameState_getCurrentTurn(state) == turn ? endgameValue : -endgameValue;
+            } else if (scoreDifference) {
+                ctx->heuristicCalls++;
+            } else {
+                // Any other heuristic is called on the child (or queued for its batch
+                // version), and replaces the score difference.
+                batch->own[i] = 0;
+                batch->other[i] = 0;
+
+                double value;
+                if (batchHeuristic == NULL) {
+                    batch->extra[i] = sign * evaluate(ctx, state);
+                } else if (usesEvalCache(ctx) && EvalCache_probe(ctx->evalCache, state, perspective, &value)) {
+                    ctx->evalCacheHits++;
+                    batch->extra[i] = sign * value;
+                } else {
+                    batch->states[pending] = *state;
+                    batch->lanes[pending++] = i;
+                }
+            }
+        }
+
+        GameState_unmakeMove(state, &undo);
     }
 
-    depth--;
-    double v = -INFINITY;
-    int newBestMove = -2;
+    // Children missing from the evaluation cache are evaluated together, then cached.
+    if (pending > 0) {
+        double values[BATCH_LANES];
+        ctx->heuristicCalls += pending;
+        batchHeuristic(batch->states, pending, perspective, values);
 
-    LinkedList validMoves = GameState_getValidMoves(state);
-
-    for (Node a = LinkedList_head(validMoves); a != NULL; a = Node_next(a)) {
-        GameState newState = GameState_move(state, Node_value(a), false);
-        double v2;
-        int a2;
-
-        // Maximize the value again if player is unchanged.
-        if (GameState_getCurrentTurn(newState) == GameState_getCurrentTurn(state)) {
-            maxValue(
-                &v2, &a2,
-                newState,
-                alpha,
-                beta,
-                optimizeFor,
-                depth);
-        } else {
-            minValue(
-                &v2, &a2,
-                newState,
-                alpha,
-                beta,
-                optimizeFor,
-                depth);
+        for (int j = 0; j < pending; j++) {
+            if (usesEvalCache(ctx)) EvalCache_store(ctx->evalCache, &batch->states[j], perspective, values[j]);
+            batch->extra[batch->lanes[j]] = sign * values[j];
         }
+    }
 
-        GameState_free(newState);
+    scoreBatch(batch, sign);
+}
 
-        if (v2 > v) {
-            v = v2;
-            newBestMove = Node_value(a);
-            alpha = alpha > v ? alpha : v;
+/**
+ * Search one child of a node with a principal variation search window.
+ *
+ * @return The child's value for the side to move at the node
+ */
+static double searchChild(
+    SearchContext ctx,
+    GameState state,
+    GameStateUndo* undo,
+    const int move,
+    const int index,
+    const double alpha,
+    const double beta,
+    const int depth)
+{
+    const int turn = GameState_getCurrentTurn(state);
+    GameState_makeMove(state, move, undo);
+    const bool sameTurn = GameState_getCurrentTurn(state) == turn;
+    double v2;
+    int a2;
+
+    if (index == 0) {
+        // Search the first (expected best) move with the full window.
+        if (sameTurn) {
+            negamax(ctx, &v2, &a2, state, alpha, beta, depth);
+        } else {
+            negamax(ctx, &v2, &a2, state, -beta, -alpha, depth);
+            v2 = -v2;
+        }
+    } else {
+        // Check whether the move beats alpha with a null window...
+        const double nullBeta = nextafter(alpha, INFINITY);
+        if (sameTurn) {
+            negamax(ctx, &v2, &a2, state, alpha, nullBeta, depth);
+        } else {
+            negamax(ctx, &v2, &a2, state, -nullBeta, -alpha, depth);
+            v2 = -v2;
         }
 
-        // Alpha > beta  ==>  prune
-        if (v >= beta) {
-            *util = v;
-            *bestMove = newBestMove;
-            LinkedList_free(validMoves);
-            return;
+        // ...and find its real value if it does.
+        if (v2 > alpha && v2 < beta) {
+            if (sameTurn) {
+                negamax(ctx, &v2, &a2, state, v2, beta, depth);
+            } else {
+                negamax(ctx, &v2, &a2, state, -beta, -v2, depth);
+                v2 = -v2;
+            }
         }
     }
 
-    *util = v;
-    *bestMove = newBestMove;
-    LinkedList_free(validMoves);
+    GameState_unmakeMove(state, undo);
+    return v2;
 }
 
-
-static void minValue(
+/**
+ * Negamax search with alpha-beta pruning and principal variation search.
+ * Values are from the point of view of the player to move in state. When a
+ * move gives the same player another turn, the child's value is used as is;
+ * otherwise it is negated, along with the window.
+ *
+ * After the first move, moves are searched with a null window to prove they
+ * are no better than the best so far, and only searched again with the full
+ * window if they turn out to be better.
+ */
+static void negamax(
+    SearchContext ctx,
     double* util,
     int* bestMove,
     GameState state,
-    const double alpha,
+    double alpha,
     double beta,
-    const int optimizeFor,
     int depth)
 {
+    const int turn = GameState_getCurrentTurn(state);
+    const double sign = turn == ctx->perspective ? 1 : -1;
+
     // If we are in a terminal state, evaluate utility.
     if (GameState_isTerminal(state)) {
-        *util = utility(state, optimizeFor);
+        ctx->leaves++;
+        *util = sign * utility(state, ctx->perspective);
         *bestMove = -2;
         return;
     }
 
-    struct timespec timer;
-    clock_gettime(CLOCK_MONOTONIC, &timer);
-    const time_t now = timespecToMs(timer);
+    ctx->nodes++;
+
+    if (Timer_poll(ctx->timer) || atomic_load_explicit(ctx->stopFlag, memory_order_relaxed))
+        ctx->timeUp = true;
 
-    // If we have reached artificial limit, use the heuristic.
-    if (depth <= 0 || (limit > 0 && now > start + limit)) {
-        *util = h(state, optimizeFor);
+    const int nodeDepth = depth;
+    const int ply = ctx->iterationDepth - nodeDepth;
+
+    // Positions in the endgame database have an exact value: the current score
+    // difference plus the net stones still to come. The root always searches,
+    // so that it produces a move.
+    int endgameValue;
+    if (ply > 0 && Endgame_probe(ctx->endgame, state, &endgameValue)) {
+        ctx->leaves++;
+        *util = sign * utility(state, ctx->perspective) + endgameValue;
+        *bestMove = -2;
+        return;
+    }
+
+    // If we have reached artificial limit, use the heuristic. It always
+    // evaluates for the root player, so the search works with asymmetric heuristics.
+    if (depth <= 0 || ctx->timeUp) {
+        ctx->leaves++;
+        *util = sign * evaluate(ctx, state);
         *bestMove = -2;
         return;
     }
 
+    // Use a stored result if it was searched at least as deeply. The root
+    // always searches, so that it produces a move.
+    const uint64_t key = GameState_getHash(state);
+    double ttValue;
+    int ttDepth, ttMove = -2;
+    TTBound ttBound;
+    const bool ttHit = TTable_probe(ctx->table, key, &ttValue, &ttDepth, &ttBound, &ttMove);
+    if (ttHit) ctx->tableHits++;
+
+    if (ttHit && ttDepth >= depth && ply > 0) {
+        if (ttBound == TT_EXACT) {
+            *util = ttValue;
+            *bestMove = ttMove;
+            return;
+        }
+
+        if (ttBound == TT_LOWER) alpha = alpha > ttValue ? alpha : ttValue;
+        if (ttBound == TT_UPPER) beta = beta < ttValue ? beta : ttValue;
+
+        if (alpha >= beta) {
+            *util = ttValue;
+            *bestMove = ttMove;
+            return;
+        }
+    }
+
+    const double alphaOrig = alpha;
+    SearchFrame* const frame = &ctx->frames[ply];
     depth--;
-    double v = INFINITY;
+    double v = -INFINITY;
     int newBestMove = -2;
 
-    LinkedList validMoves = GameState_getValidMoves(state);
-
-    for (Node a = LinkedList_head(validMoves); a != NULL; a = Node_next(a)) {
-        GameState newState = GameState_move(state, Node_value(a), false);
-        double v2;
-        int a2;
-
-        // Minimize the value again if player is unchanged.
-        if (GameState_getCurrentTurn(newState) == GameState_getCurrentTurn(state)) {
-            minValue(
-                &v2, &a2,
-                newState,
-                alpha,
-                beta,
-                optimizeFor,
-                depth);
-        } else {
-            maxValue(
-                &v2, &a2,
-                newState,
-                alpha,
-                beta,
-                optimizeFor,
-                depth);
-        }
+    // Try the previous iteration's best move first at the root, and the stored best move elsewhere.
+    MoveList* const validMoves = &frame->moves;
+    GameState_generateMoves(state, validMoves);
+    orderMoves(ctx, state, validMoves, ply == 0 && ctx->pvMove != -2 ? ctx->pvMove : ttMove, ply);
+
+    // One ply above the horizon, every child is a leaf, so children are evaluated
+    // in a batch instead of searched. The first child usually cuts off on its own,
+    // so it goes first. The rest follow together if needed, when the heuristic is
+    // cheap to batch (the default one, or one with a batch version); otherwise they
+    // follow one at a time, so a cutoff saves the remaining heuristic calls. Leaf
+    // values are exact whatever the window, so this matches searching them in turn.
+    const bool frontier = depth == 0;
+    const bool batched = ctx->h == heuristic || ctx->h == ctx->batchFor;
 
-        GameState_free(newState);
+    for (int i = 0; i < validMoves->size; i++) {
+        const int move = validMoves->moves[i];
+        if (frontier && (i <= 1 || !batched))
+            expandFrontier(ctx, state, validMoves, i, batched && i == 1 ? validMoves->size : i + 1, sign);
 
-        if (v2 < v) {
+        const double v2 = frontier
+            ? ctx->batch.values[i]
+            : searchChild(ctx, state, &frame->undo, move, i, alpha, beta, depth);
+
+        // An interrupted search's value is meaningless, so only count moves searched completely.
+        if (ctx->timeUp) break;
+
+        if (v2 > v) {
             v = v2;
-            newBestMove = Node_value(a);
-            beta = beta < v ? beta : v;
+            newBestMove = move;
+            alpha = alpha > v ? alpha : v;
         }
 
         // Alpha > beta  ==>  prune
-        if (v <= alpha) {
-            *util = v;
-            *bestMove = newBestMove;
-            LinkedList_free(validMoves);
-            return;
+        if (v >= beta) {
+            recordCutoff(ctx, state, move, i, ply, nodeDepth);
+            break;
         }
     }
 
-    *util = v;
-    *bestMove = newBestMove;
-    LinkedList_free(validMoves);
-}
-
+    // Results from an interrupted search are unreliable, so don't store them.
+    if (!ctx->timeUp) {
+        const TTBound bound = v >= beta ? TT_LOWER : v <= alphaOrig ? TT_UPPER : TT_EXACT;
+        if (TTable_store(ctx->table, key, v, nodeDepth, bound, newBestMove)) ctx->tableOverwrites++;
+    }
 
+    *util = v;
 
+    // If time ran out, only report a move proven better than the window's
+    // lower bound (at the root, the previous iteration's best move is searched
+    // first, so such a move is at least as good).
+    *bestMove = ctx->timeUp && v <= alphaOrig ? -2 : newBestMove;
+}
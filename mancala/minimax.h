@@ -2,14 +2,25 @@
  * project:  Mancalamax
  * file:     minimax.h
  * author:   Ethan Mentzer
- * modified: 2025-03-08
+ * modified: 2026-10-16
  */
 
 #ifndef MINIMAX_H
 #define MINIMAX_H
 
+#include <stddef.h>
+#include <stdatomic.h>
 #include <time.h>
 #include "state.h"
+#include "endgame.h"
+#include "book.h"
+#include "evalcache.h"
+#include "nnue.h"
+
+/**
+ * The default number of transposition table entries.
+ */
+#define MINIMAX_DEFAULT_TABLE_ENTRIES ((size_t)1 << 20)
 
 /**
  * Typedef representing a heuristic function, which takes a
@@ -17,21 +28,332 @@
  */
 typedef double (*Heuristic)(GameState, int);
 
+/**
+ * Typedef representing a batch version of a heuristic, which sets values[i]
+ * to the heuristic's value of states[i] for the player, for count states.
+ * Searches call it on the children of a frontier node, so it can share work
+ * between them.
+ */
+typedef void (*BatchHeuristic)(const struct GameState* states, int count, int player, double* values);
+
+/**
+ * The number of iterations kept in SearchStats (the most recent ones).
+ */
+#define SEARCHSTATS_MAX_ITERATIONS 64
+
+/**
+ * A completed iteration of an iterative deepening search.
+ */
+typedef struct SearchIteration {
+    int depth;      // depth of the iteration
+    int move;       // best move found
+    double score;   // score of the best move, for the player to move
+    size_t nodes;   // nodes visited by the iteration
+    double time;    // time (in ms) from the start of the search to the end of the iteration
+} SearchIteration;
+
+/**
+ * Statistics of a search, filled in on request by SearchContext_getStats.
+ * Counts include the helper threads of a parallel search.
+ */
+typedef struct SearchStats {
+    size_t nodes;                            // interior and leaf nodes visited
+    size_t leaves;                           // nodes evaluated without searching further
+    size_t heuristicCalls;                   // leaves evaluated by the heuristic
+    size_t evalCacheHits;                    // leaves whose value was found in the evaluation cache
+    size_t cutoffs;                          // beta cutoffs
+    size_t cutoffsAt[GAMESTATE_MAX_MOVES];   // beta cutoffs by index of the cutting move in the ordered list
+    double branchingFactor;                  // effective branching factor of the iterations (0 if unknown)
+    int firstDepth;                          // depth of the first iteration
+    int completedDepth;                      // deepest completed iteration
+    double score;                            // score of the deepest completed iteration
+    bool aborted;                            // whether the last iteration was stopped by the time limit
+    double time;                             // total time (in ms)
+    SearchIteration iterations[SEARCHSTATS_MAX_ITERATIONS];  // completed iterations, oldest first
+    int iterationCount;                      // number of iterations in the array
+} SearchStats;
+
+/**
+ * A SearchContext holds everything a search needs: the deadline, heuristic,
+ * statistics, transposition table and scratch memory. Searches on different
+ * contexts are independent, so they can run at the same time (for different
+ * games, or on different threads). A single context must not be used by two
+ * searches at once.
+ *
+ * The endgame database, opening book, evaluation cache and network given to a
+ * context are not owned by it: several contexts can share them, and they must
+ * stay open until the last search using them is over.
+ */
+typedef struct SearchContext* SearchContext;
+
+/**
+ * Typedef representing a function called after every completed iteration
+ * of an iterative deepening search, on the searching thread.
+ */
+typedef void (*SearchCallback)(SearchContext ctx, const SearchIteration* iteration, void* data);
+
+/**
+ * Create a new SearchContext.
+ *
+ * @param tableEntries The number of transposition table entries (0 disables the table)
+ * @return A pointer to the new SearchContext, or NULL if allocation failed
+ */
+extern SearchContext new_SearchContext(size_t tableEntries);
+
+/**
+ * Free the memory used by a SearchContext, including its table and scratch memory.
+ */
+extern void SearchContext_free(SearchContext ctx);
+
+/**
+ * Set the number of transposition table entries used by future searches
+ * on a context (rounded down to a power of two). A size of 0 disables the table.
+ */
+extern void SearchContext_setTableSize(SearchContext ctx, size_t entries);
+
+/**
+ * Returns the most scratch memory (in bytes) a search to a depth can take from
+ * its context, on top of the table. It is held until the context is freed.
+ */
+extern size_t SearchContext_getScratchBytes(int maxDepth);
+
+/**
+ * Set the endgame database probed by future searches on a context.
+ *
+ * @param ctx The context
+ * @param db The database, or NULL to search without one
+ */
+extern void SearchContext_setEndgame(SearchContext ctx, Endgame db);
+
+/**
+ * Set the opening book used by future iterative deepening searches on a
+ * context: positions in the book are answered without searching.
+ *
+ * @param ctx The context
+ * @param book The book, or NULL to always search
+ */
+extern void SearchContext_setBook(SearchContext ctx, Book book);
+
+/**
+ * Give future searches on a context a batch version of a heuristic. Searches
+ * using the heuristic then evaluate the children of a frontier node left after
+ * the first with one call to the batch version. Without one, a custom heuristic
+ * is called on one child at a time, so that a cutoff saves the remaining calls.
+ *
+ * @param ctx The context
+ * @param h The heuristic
+ * @param batch The batch version of h, or NULL to call h on each child
+ */
+extern void SearchContext_setBatchHeuristic(SearchContext ctx, Heuristic h, BatchHeuristic batch);
+
+/**
+ * Set the evaluation cache used by future searches on a context. Values of a
+ * custom heuristic (or its batch version) are looked up in it before the
+ * heuristic is called, and stored after; the default heuristic and
+ * nnueHeuristic are never cached. The cache is cleared when a search uses a
+ * different heuristic than the one that filled it, whichever context filled
+ * it, so contexts searching with different heuristics at the same time must
+ * not share one.
+ *
+ * @param ctx The context
+ * @param cache The cache, or NULL to always call the heuristic
+ */
+extern void SearchContext_setEvalCache(SearchContext ctx, EvalCache cache);
+
+/**
+ * Set the network future searches on a context evaluate with when they are
+ * given nnueHeuristic. Such searches update the network's accumulator
+ * incrementally from leaf to leaf, instead of evaluating every leaf from
+ * scratch, and bypass the evaluation cache.
+ *
+ * @param ctx The context
+ * @param nnue The network, or NULL for the default network (see nnueSetDefault)
+ */
+extern void SearchContext_setNnue(SearchContext ctx, Nnue nnue);
+
+/**
+ * Set a function to call after every completed iteration of future iterative
+ * deepening searches on a context (e.g. to report progress).
+ *
+ * @param ctx The context
+ * @param callback The function, or NULL for none
+ * @param data Passed to the function
+ */
+extern void SearchContext_setCallback(SearchContext ctx, SearchCallback callback, void* data);
+
+/**
+ * Make searches on a context stop when a caller's flag is set, so another
+ * thread can stop a running search. The search never clears the flag, so a
+ * stop requested before the search begins is not lost.
+ *
+ * @param ctx The context
+ * @param flag The flag, or NULL to go back to the context's own flag
+ */
+extern void SearchContext_setStopFlag(SearchContext ctx, atomic_bool* flag);
+
+/**
+ * Set the soft time limit of future iterative deepening searches on a context:
+ * no new iteration is started after it, although the running one may continue
+ * up to the search's time limit.
+ *
+ * @param ctx The context
+ * @param softLimit The soft limit (in ms), or 0 to use the time limit
+ */
+extern void SearchContext_setSoftLimit(SearchContext ctx, time_t softLimit);
+
+/**
+ * Keep what a context learns from one search for the next, so the searches of
+ * a game (or pondering) build on each other. The table is aged rather than
+ * cleared, so entries of earlier searches are used until overwritten or too
+ * old; killer moves and history scores are carried over (history halved); and
+ * iterative deepening starts at the depth the table already holds a result
+ * for the root at. The table is still cleared when the heuristic or the player
+ * to move at the root changes, as the stored values depend on both.
+ *
+ * @param ctx The context
+ * @param keep Whether to keep the table (by default it is cleared before every search)
+ */
+extern void SearchContext_setKeepTable(SearchContext ctx, bool keep);
+
+/**
+ * Forget what a context learned in earlier searches (when it keeps its table),
+ * before searching a position from a different game.
+ */
+extern void SearchContext_newGame(SearchContext ctx);
+
+/**
+ * Same as minimaxIterDep, using the given context.
+ */
+extern int SearchContext_iterDep(
+    SearchContext ctx,
+    GameState state,
+    time_t timeLimit,
+    int maxDepth,
+    Heuristic customHeuristic);
+
+/**
+ * Same as minimaxIterDepParallel, using the given context. Helper contexts
+ * are created on demand and kept by ctx for later searches.
+ */
+extern int SearchContext_iterDepParallel(
+    SearchContext ctx,
+    GameState state,
+    time_t timeLimit,
+    int maxDepth,
+    Heuristic customHeuristic,
+    int threads);
+
+/**
+ * Same as minimaxAlphaBeta, using the given context.
+ */
+extern int SearchContext_alphaBeta(
+    SearchContext ctx,
+    GameState state,
+    int maxDepth,
+    Heuristic customHeuristic);
+
+/**
+ * Same as minimaxGetTableStats, for the most recent search on a context.
+ */
+extern void SearchContext_getTableStats(SearchContext ctx, size_t* hits, size_t* overwrites);
+
+/**
+ * Same as minimaxGetMemoryStats, for the most recent search on a context.
+ */
+extern void SearchContext_getMemoryStats(SearchContext ctx, size_t* peakBytes, size_t* allocations);
+
+/**
+ * Returns the number of nodes visited by the most recent search on a context,
+ * including the nodes of any helper threads.
+ */
+extern size_t SearchContext_getNodes(SearchContext ctx);
+
+/**
+ * Report how often the first move searched at a node caused a cutoff, for the
+ * most recent search on a context (including helper threads). The ratio of
+ * the two is the first-move cutoff rate, a measure of move ordering quality.
+ *
+ * @param cutoffs Set to the number of cutoffs (can be NULL)
+ * @param firstMoveCutoffs Set to the number of cutoffs caused by the first move searched (can be NULL)
+ */
+extern void SearchContext_getCutoffStats(SearchContext ctx, size_t* cutoffs, size_t* firstMoveCutoffs);
+
+/**
+ * Returns the deepest iteration the most recent iterative deepening search on
+ * a context completed before time ran out (0 if none).
+ */
+extern int SearchContext_getCompletedDepth(SearchContext ctx);
+
+/**
+ * Find the principal variation of a state, by following the best moves
+ * stored in a context's transposition table. Only valid during or right
+ * after a search of the state.
+ *
+ * @param ctx The context that searched the state
+ * @param state The state to start from
+ * @param moves Filled in with the moves of the variation
+ * @param maxMoves The size of the moves array
+ * @return The number of moves found
+ */
+extern int SearchContext_getPV(SearchContext ctx, GameState state, int* moves, int maxMoves);
+
+/**
+ * Fill in the statistics of the most recent search on a context. The
+ * counters are kept by every search, so asking costs nothing extra.
+ */
+extern void SearchContext_getStats(SearchContext ctx, SearchStats* stats);
+
+/**
+ * Returns the score of the deepest completed iteration of the most recent
+ * iterative deepening search on a context (or of the book move it played),
+ * from the point of view of the player to move.
+ */
+extern double SearchContext_getScore(SearchContext ctx);
+
+/*
+ * The functions below share a single default SearchContext, so they must not
+ * be called from several threads at once. Use the SearchContext functions
+ * above to run independent searches.
+ */
+
 /**
  * Find the optimal move using iterative deepening and minimax / alpha-beta pruning.
- * Starts at depth 2, and increases the depth until time runs out.
+ * Starts at depth 2, and increases the depth until time runs out. A depth is
+ * not started if the growth of the previous iterations predicts it cannot
+ * finish in time.
  *
  * If time runs out during the search of a given depth, the result found for the
- * previous depth is returned, as it is considered a more complete search.
+ * previous depth is returned, unless a root move that was searched completely
+ * at the new depth proved better.
  *
  * @param state The state to search
- * @param timeLimit The maximum amount of time (in ms) to spend searching
+ * @param timeLimit The maximum amount of time (in ms) to spend searching (0 for no limit)
  * @param maxDepth The maximum depth to search before time runs out
  * @param customHeuristic The heuristic function to use. Can be NULL to use the default.
  * @return The optimal move, or a random move if the search failed
  */
 extern int minimaxIterDep(GameState state, time_t timeLimit, int maxDepth, Heuristic customHeuristic);
 
+/**
+ * Same as minimaxIterDep, but searches with several threads ("Lazy SMP").
+ * Helper threads run their own iterative deepening loops at staggered depths,
+ * sharing one transposition table with the main thread. The main thread's
+ * result is returned; the helpers only speed it up through the shared table.
+ *
+ * @param state The state to search
+ * @param timeLimit The maximum amount of time (in ms) to spend searching (0 for no limit)
+ * @param maxDepth The maximum depth to search before time runs out
+ * @param customHeuristic The heuristic function to use. Can be NULL to use the default.
+ * @param threads The total number of search threads, including the calling thread
+ * @return The optimal move, or a random move if the search failed
+ */
+extern int minimaxIterDepParallel(
+    GameState state,
+    time_t timeLimit,
+    int maxDepth,
+    Heuristic customHeuristic,
+    int threads);
+
 /**
  * Find the optimal move using minimax with alpha-beta pruning.
  *
@@ -42,4 +364,57 @@ extern int minimaxIterDep(GameState state, time_t timeLimit, int maxDepth, Heuri
  */
 extern int minimaxAlphaBeta(GameState state, int maxDepth, Heuristic customHeuristic);
 
+/**
+ * Set the number of transposition table entries used by future searches
+ * (rounded down to a power of two). A size of 0 disables the table.
+ */
+extern void minimaxSetTableSize(size_t entries);
+
+/**
+ * Set the endgame database probed by future searches (NULL for none).
+ * The database must stay open while it is in use.
+ */
+extern void minimaxSetEndgame(Endgame db);
+
+/**
+ * Set the opening book used by future iterative deepening searches (NULL for none).
+ * The book must stay open while it is in use.
+ */
+extern void minimaxSetBook(Book book);
+
+/**
+ * Give future searches a batch version of a heuristic (NULL for none).
+ * See SearchContext_setBatchHeuristic.
+ */
+extern void minimaxSetBatchHeuristic(Heuristic h, BatchHeuristic batch);
+
+/**
+ * Set the evaluation cache used by future searches (NULL for none).
+ * The cache must stay allocated while it is in use.
+ */
+extern void minimaxSetEvalCache(EvalCache cache);
+
+/**
+ * Fill in the statistics of the most recent search.
+ */
+extern void minimaxGetStats(SearchStats* stats);
+
+/**
+ * Report transposition table counters for the most recent search.
+ *
+ * @param hits Set to the number of successful table probes (can be NULL)
+ * @param overwrites Set to the number of entries evicted by other positions (can be NULL)
+ */
+extern void minimaxGetTableStats(size_t* hits, size_t* overwrites);
+
+/**
+ * Report scratch memory usage for the most recent search. Search-time
+ * allocations come from a per-search arena that is reset after every
+ * iterative deepening iteration.
+ *
+ * @param peakBytes Set to the largest number of arena bytes in use at once (can be NULL)
+ * @param allocations Set to the number of arena allocations made (can be NULL)
+ */
+extern void minimaxGetMemoryStats(size_t* peakBytes, size_t* allocations);
+
 #endif //MINIMAX_H
@@ -0,0 +1,353 @@
+/*
+ * project:  Mancalamax
+ * file:     nnue.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "nnue.h"
+
+
+#define NNUE_MAGIC "MNCLNNUE"
+#define NNUE_VERSION 1
+
+// Right shift of the second layer's sums, back into the activation range.
+#define NNUE_L2_SHIFT 6
+
+// Largest activation of the clipped ReLU.
+#define NNUE_ACTIVATION_MAX 127
+
+/**
+ * The header at the start of a network file.
+ */
+typedef struct NnueHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pits;
+    uint32_t buckets;
+    uint32_t hidden;
+    uint32_t hidden2;
+    int32_t scale;
+} NnueHeader;
+
+_Static_assert(sizeof(NnueHeader) == 32, "network header must be 32 bytes");
+_Static_assert(NNUE_HIDDEN % 16 == 0 && NNUE_HIDDEN2 % 16 == 0, "layer sizes must be multiples of 16");
+
+/**
+ * A memory-mapped network. The weight pointers point into the mapping.
+ */
+struct Nnue {
+    void* map;
+    size_t mapSize;
+    int pits;
+    double scale;
+    const int16_t* w1;
+    const int16_t* b1;
+    const int8_t* w2;
+    const int32_t* b2;
+    const int8_t* w3;
+    int32_t b3;
+};
+
+static Nnue defaultNnue = NULL;
+
+/**
+ * Returns the size in bytes of the weights of a network for a board size.
+ */
+static size_t weightsSize(const int pits) {
+    const size_t features = (size_t)2 * pits * NNUE_BUCKETS;
+    return sizeof(int16_t) * (features * NNUE_HIDDEN + NNUE_HIDDEN)
+        + sizeof(int8_t) * NNUE_HIDDEN2 * NNUE_HIDDEN
+        + sizeof(int32_t) * NNUE_HIDDEN2
+        + sizeof(int8_t) * NNUE_HIDDEN2
+        + sizeof(int32_t);
+}
+
+static int bucketOf(const int stones) {
+    return stones < NNUE_BUCKETS - 1 ? stones : NNUE_BUCKETS - 1;
+}
+
+/**
+ * Returns the first layer's weight column of a feature, for the accumulator of a player.
+ */
+static const int16_t* column(Nnue nnue, const int player, const int side, const int pit, const int bucket) {
+    const int relative = side == player ? 0 : 1;
+    return nnue->w1 + ((size_t)(relative * nnue->pits + pit) * NNUE_BUCKETS + bucket) * NNUE_HIDDEN;
+}
+
+/**
+ * Move a pit's feature from one bucket to another, in both players' accumulators.
+ * The loops have a fixed trip count, so the compiler vectorizes them.
+ */
+static void moveFeature(Nnue nnue, NnueAccumulator* acc, const int side, const int pit, const int from, const int to) {
+    for (int player = 0; player < 2; player++) {
+        const int16_t* const removed = column(nnue, player, side, pit, from);
+        const int16_t* const added = column(nnue, player, side, pit, to);
+        int16_t* const values = acc->values[player];
+
+        for (int i = 0; i < NNUE_HIDDEN; i++) values[i] += added[i] - removed[i];
+    }
+}
+
+/**
+ * Compute the second and output layers from a player's accumulator.
+ */
+static int32_t propagate(Nnue nnue, const int16_t* accumulator) {
+    int32_t hidden2[NNUE_HIDDEN2];
+
+#if defined(__SSE2__)
+    // Clip the accumulator into int16 lanes, then multiply by the int8 weights
+    // (sign-extended to int16) and add pairs of products into int32 lanes.
+    __m128i active[NNUE_HIDDEN / 8];
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top = _mm_set1_epi16(NNUE_ACTIVATION_MAX);
+
+    for (int i = 0; i < NNUE_HIDDEN / 8; i++) {
+        const __m128i values = _mm_load_si128((const __m128i*)(accumulator + 8 * i));
+        active[i] = _mm_min_epi16(_mm_max_epi16(values, zero), top);
+    }
+
+    for (int j = 0; j < NNUE_HIDDEN2; j++) {
+        const int8_t* const row = nnue->w2 + (size_t)j * NNUE_HIDDEN;
+        __m128i sum = zero;
+
+        for (int i = 0; i < NNUE_HIDDEN / 16; i++) {
+            const __m128i bytes = _mm_loadu_si128((const __m128i*)(row + 16 * i));
+            const __m128i low = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+            const __m128i high = _mm_srai_epi16(_mm_unpackhi_epi8(bytes, bytes), 8);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(active[2 * i], low));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(active[2 * i + 1], high));
+        }
+
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        hidden2[j] = nnue->b2[j] + _mm_cvtsi128_si32(sum);
+    }
+#else
+    int16_t active[NNUE_HIDDEN];
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        const int16_t value = accumulator[i];
+        active[i] = value < 0 ? 0 : value > NNUE_ACTIVATION_MAX ? NNUE_ACTIVATION_MAX : value;
+    }
+
+    for (int j = 0; j < NNUE_HIDDEN2; j++) {
+        const int8_t* const row = nnue->w2 + (size_t)j * NNUE_HIDDEN;
+        int32_t sum = nnue->b2[j];
+        for (int i = 0; i < NNUE_HIDDEN; i++) sum += row[i] * active[i];
+        hidden2[j] = sum;
+    }
+#endif
+
+    int32_t output = nnue->b3;
+    for (int j = 0; j < NNUE_HIDDEN2; j++) {
+        const int32_t value = hidden2[j] >> NNUE_L2_SHIFT;
+        output += nnue->w3[j] * (value < 0 ? 0 : value > NNUE_ACTIVATION_MAX ? NNUE_ACTIVATION_MAX : value);
+    }
+
+    return output;
+}
+
+
+Nnue new_Nnue(const char* path) {
+    if (path == NULL) return NULL;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    NnueHeader header;
+    struct stat info;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)
+        || memcmp(header.magic, NNUE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != NNUE_VERSION
+        || header.pits < 1 || header.pits > GAMESTATE_MAX_PITS
+        || header.buckets != NNUE_BUCKETS
+        || header.hidden != NNUE_HIDDEN
+        || header.hidden2 != NNUE_HIDDEN2
+        || header.scale <= 0
+        || fstat(fd, &info) != 0
+        || (uint64_t)info.st_size < sizeof(header) + weightsSize((int)header.pits)) {
+        close(fd);
+        return NULL;
+    }
+
+    struct Nnue* const newNnue = (Nnue)malloc(sizeof(struct Nnue));
+    if (newNnue == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    newNnue->mapSize = sizeof(header) + weightsSize((int)header.pits);
+    newNnue->map = mmap(NULL, newNnue->mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (newNnue->map == MAP_FAILED) {
+        free(newNnue);
+        return NULL;
+    }
+
+    newNnue->pits = (int)header.pits;
+    newNnue->scale = header.scale;
+
+    // The layers follow the header in order; every array starts 4-byte aligned.
+    const unsigned char* p = (const unsigned char*)newNnue->map + sizeof(header);
+    const size_t features = (size_t)2 * newNnue->pits * NNUE_BUCKETS;
+    newNnue->w1 = (const int16_t*)p;
+    p += sizeof(int16_t) * features * NNUE_HIDDEN;
+    newNnue->b1 = (const int16_t*)p;
+    p += sizeof(int16_t) * NNUE_HIDDEN;
+    newNnue->w2 = (const int8_t*)p;
+    p += sizeof(int8_t) * NNUE_HIDDEN2 * NNUE_HIDDEN;
+    newNnue->b2 = (const int32_t*)p;
+    p += sizeof(int32_t) * NNUE_HIDDEN2;
+    newNnue->w3 = (const int8_t*)p;
+    p += sizeof(int8_t) * NNUE_HIDDEN2;
+    memcpy(&newNnue->b3, p, sizeof(int32_t));
+
+    return newNnue;
+}
+
+void Nnue_free(Nnue nnue) {
+    if (nnue == NULL) return;
+    if (defaultNnue == nnue) defaultNnue = NULL;
+    munmap(nnue->map, nnue->mapSize);
+    free(nnue);
+}
+
+int Nnue_getPits(Nnue nnue) {
+    if (nnue == NULL) return 0;
+    return nnue->pits;
+}
+
+void Nnue_refresh(Nnue nnue, NnueAccumulator* acc, GameState state) {
+    if (nnue == NULL || acc == NULL || state == NULL) return;
+
+    if (state->pits != nnue->pits) {
+        acc->pits = 0;
+        return;
+    }
+
+    for (int side = 0; side < 2; side++) {
+        for (int pit = 0; pit < GAMESTATE_MAX_PITS; pit++)
+            acc->buckets[side][pit] = pit < nnue->pits ? (uint8_t)bucketOf(state->players[side][pit]) : 0;
+    }
+
+    for (int player = 0; player < 2; player++) {
+        int16_t* const values = acc->values[player];
+        for (int i = 0; i < NNUE_HIDDEN; i++) values[i] = nnue->b1[i];
+
+        for (int side = 0; side < 2; side++) {
+            for (int pit = 0; pit < nnue->pits; pit++) {
+                const int16_t* const weights = column(nnue, player, side, pit, acc->buckets[side][pit]);
+                for (int i = 0; i < NNUE_HIDDEN; i++) values[i] += weights[i];
+            }
+        }
+    }
+
+    acc->pits = nnue->pits;
+}
+
+void Nnue_update(Nnue nnue, NnueAccumulator* acc, GameState state) {
+    if (nnue == NULL || acc == NULL || state == NULL) return;
+
+    if (acc->pits != nnue->pits || state->pits != nnue->pits) {
+        Nnue_refresh(nnue, acc, state);
+        return;
+    }
+
+    // A move changes the pits it sows into, and any it captures or sweeps;
+    // buckets only change for some of those.
+    for (int side = 0; side < 2; side++) {
+        for (int pit = 0; pit < nnue->pits; pit++) {
+            const int bucket = bucketOf(state->players[side][pit]);
+            if (bucket == acc->buckets[side][pit]) continue;
+
+            moveFeature(nnue, acc, side, pit, acc->buckets[side][pit], bucket);
+            acc->buckets[side][pit] = (uint8_t)bucket;
+        }
+    }
+}
+
+double Nnue_evaluate(Nnue nnue, const NnueAccumulator* acc, GameState state, const int player) {
+    if (state == NULL) return 0;
+
+    const int opponent = player == 0 ? 1 : 0;
+    const double difference = GameState_getScore(state, player) - GameState_getScore(state, opponent);
+    if (nnue == NULL || acc == NULL || acc->pits != nnue->pits) return difference;
+
+    return difference + propagate(nnue, acc->values[player]) / nnue->scale;
+}
+
+double Nnue_evaluateState(Nnue nnue, GameState state, const int player) {
+    NnueAccumulator acc;
+    acc.pits = 0;
+    Nnue_refresh(nnue, &acc, state);
+    return Nnue_evaluate(nnue, &acc, state, player);
+}
+
+bool Nnue_create(const char* path, const int pits, unsigned int seed) {
+    if (path == NULL || pits < 1 || pits > GAMESTATE_MAX_PITS) return false;
+
+    NnueHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, NNUE_MAGIC, sizeof(header.magic));
+    header.version = NNUE_VERSION;
+    header.pits = (uint32_t)pits;
+    header.buckets = NNUE_BUCKETS;
+    header.hidden = NNUE_HIDDEN;
+    header.hidden2 = NNUE_HIDDEN2;
+    header.scale = 1024;
+
+    const size_t features = (size_t)2 * pits * NNUE_BUCKETS;
+    const size_t size = weightsSize(pits);
+    unsigned char* const weights = (unsigned char*)malloc(size);
+    if (weights == NULL) return false;
+
+    // Small weights around zero, and first layer biases that keep most
+    // activations inside the clipping range.
+    unsigned char* p = weights;
+    for (size_t i = 0; i < features * NNUE_HIDDEN; i++, p += sizeof(int16_t)) {
+        const int16_t value = (int16_t)(rand_r(&seed) % 9 - 4);
+        memcpy(p, &value, sizeof(value));
+    }
+    for (int i = 0; i < NNUE_HIDDEN; i++, p += sizeof(int16_t)) {
+        const int16_t value = 48;
+        memcpy(p, &value, sizeof(value));
+    }
+    for (int i = 0; i < NNUE_HIDDEN2 * NNUE_HIDDEN; i++) *p++ = (unsigned char)(int8_t)(rand_r(&seed) % 33 - 16);
+    for (int i = 0; i < NNUE_HIDDEN2; i++, p += sizeof(int32_t)) memset(p, 0, sizeof(int32_t));
+    for (int i = 0; i < NNUE_HIDDEN2; i++) *p++ = (unsigned char)(int8_t)(rand_r(&seed) % 33 - 16);
+    memset(p, 0, sizeof(int32_t));
+
+    FILE* const file = fopen(path, "wb");
+    bool written = file != NULL
+        && fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(weights, 1, size, file) == size;
+    if (file != NULL && fclose(file) != 0) written = false;
+
+    free(weights);
+    return written;
+}
+
+void nnueSetDefault(Nnue nnue) {
+    defaultNnue = nnue;
+}
+
+Nnue nnueGetDefault() {
+    return defaultNnue;
+}
+
+double nnueHeuristic(GameState state, const int player) {
+    return Nnue_evaluateState(defaultNnue, state, player);
+}
@@ -0,0 +1,141 @@
+/*
+ * project:  Mancalamax
+ * file:     nnue.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "state.h"
+
+/**
+ * Shape of the network. A pit's stone count is one-hot encoded into
+ * NNUE_BUCKETS buckets (counts of NNUE_BUCKETS - 1 or more share the last).
+ */
+#define NNUE_BUCKETS 16
+#define NNUE_HIDDEN 64
+#define NNUE_HIDDEN2 16
+
+/**
+ * Quantized neural network evaluator ("NNUE"), for one board size.
+ *
+ * For the player it evaluates for, the inputs are one feature per side (own
+ * or opponent's), pit and stone count bucket, so a position has 2 * pits
+ * active features. The first layer sums their int16 weight columns into an
+ * accumulator, which changes only in the columns of the pits a move changes.
+ * Then, with a clipped ReLU to [0, 127] after each layer:
+ *
+ *   hidden2 = (b2 + W2 * clip(accumulator)) >> 6     (int8 weights, int32 sums)
+ *   output  = b3 + w3 . clip(hidden2)                (int8 weights, int32 sum)
+ *   value   = store difference + output / scale      (in stones)
+ *
+ * so a network with no weights is the default heuristic, and training only
+ * has to learn the correction from the position of the stones in the pits.
+ *
+ * File layout (native byte order), memory-mapped read-only and shared:
+ *   - A 32 byte header: magic "MNCLNNUE", uint32 version, uint32 pits,
+ *     uint32 buckets, uint32 hidden, uint32 hidden2 (which must match the
+ *     shape above), and int32 scale.
+ *   - int16 W1[2 * pits * buckets][hidden], feature (side * pits + pit) * buckets + bucket,
+ *     with side 0 for the evaluated player's pits
+ *   - int16 b1[hidden]
+ *   - int8 W2[hidden2][hidden]
+ *   - int32 b2[hidden2]
+ *   - int8 w3[hidden2]
+ *   - int32 b3
+ */
+typedef struct Nnue* Nnue;
+
+/**
+ * The first layer of a network for one position, from both players' points
+ * of view, with the buckets it was computed for. Meant to live on the caller's
+ * stack (or in a search context); pits == 0 marks an empty accumulator.
+ */
+typedef struct NnueAccumulator {
+    _Alignas(16) int16_t values[2][NNUE_HIDDEN];
+    uint8_t buckets[2][GAMESTATE_MAX_PITS];
+    int pits;
+} NnueAccumulator;
+
+/**
+ * Open a network file.
+ *
+ * @param path The path of the weights file
+ * @return A pointer to the network, or NULL if the file could not be opened or is invalid
+ */
+extern Nnue new_Nnue(const char* path);
+
+/**
+ * Close a network.
+ */
+extern void Nnue_free(Nnue nnue);
+
+/**
+ * Returns the number of pits per player of the boards a network evaluates.
+ */
+extern int Nnue_getPits(Nnue nnue);
+
+/**
+ * Compute the accumulator of a state from scratch.
+ */
+extern void Nnue_refresh(Nnue nnue, NnueAccumulator* acc, GameState state);
+
+/**
+ * Bring an accumulator computed for one state up to date for another (e.g.
+ * after a move), by only changing the features of pits whose bucket differs.
+ * An empty accumulator, or one for another board size, is refreshed.
+ */
+extern void Nnue_update(Nnue nnue, NnueAccumulator* acc, GameState state);
+
+/**
+ * Evaluate a state from its (up to date) accumulator.
+ *
+ * @param nnue The network
+ * @param acc The accumulator of the state
+ * @param state The state
+ * @param player The player to evaluate for
+ * @return The value of the state for the player, in stones
+ */
+extern double Nnue_evaluate(Nnue nnue, const NnueAccumulator* acc, GameState state, int player);
+
+/**
+ * Evaluate a state from scratch. States of another board size get the
+ * default heuristic's value (the store difference).
+ */
+extern double Nnue_evaluateState(Nnue nnue, GameState state, int player);
+
+/**
+ * Write a network file with small random weights: a starting point for
+ * training, and something to test and benchmark the evaluator with.
+ *
+ * @param path The path of the file to write
+ * @param pits The number of pits per player
+ * @param seed The seed of the random weights
+ * @return Whether the file was written
+ */
+extern bool Nnue_create(const char* path, int pits, unsigned int seed);
+
+/**
+ * Set the network used by nnueHeuristic (NULL for none). The network must
+ * stay open while it is in use.
+ */
+extern void nnueSetDefault(Nnue nnue);
+
+/**
+ * Returns the network used by nnueHeuristic.
+ */
+extern Nnue nnueGetDefault();
+
+/**
+ * A Heuristic that evaluates with the default network (or the store
+ * difference without one). Searches given this heuristic recognize it, and
+ * update accumulators incrementally instead of evaluating every leaf from scratch.
+ */
+extern double nnueHeuristic(GameState state, int player);
+
+
+#endif //NNUE_H
@@ -0,0 +1,202 @@
+/*
+ * project:  Mancalamax
+ * file:     ponder.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "ponder.h"
+
+
+// Depth of the search that predicts a reply the table has no move for.
+#define PONDER_PREDICT_DEPTH 6
+
+// Entries of the table used by that search.
+#define PONDER_PREDICT_TABLE_ENTRIES ((size_t)1 << 12)
+
+// Longest principal variation read from the table.
+#define PONDER_MAX_PV 64
+
+struct Ponder {
+    SearchContext ctx;
+    atomic_bool stop;
+
+    // The background search, the position it searches, and its result.
+    pthread_t thread;
+    bool running;
+    struct GameState position;
+    int maxDepth;
+    Heuristic h;
+    int move;
+
+    // Set by the background search when it ends.
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    bool finished;
+
+    bool hit;
+};
+
+/**
+ * Background thread: search the predicted position until stopped (or done).
+ */
+static void* ponderThread(void* arg) {
+    Ponder const ponder = (Ponder)arg;
+    const int move = SearchContext_iterDep(ponder->ctx, &ponder->position, 0, ponder->maxDepth, ponder->h);
+
+    pthread_mutex_lock(&ponder->lock);
+    ponder->move = move;
+    ponder->finished = true;
+    pthread_cond_signal(&ponder->done);
+    pthread_mutex_unlock(&ponder->lock);
+
+    return NULL;
+}
+
+/**
+ * Play the opponent's predicted moves on a position, until the engine is to
+ * move (or the game ends).
+ *
+ * @return Whether a position with the engine to move was reached
+ */
+static bool predictReply(Ponder ponder, GameState position, Heuristic customHeuristic) {
+    const int opponent = GameState_getCurrentTurn(position);
+
+    // The previous search's table holds its expected continuation.
+    int pv[PONDER_MAX_PV];
+    const int length = SearchContext_getPV(ponder->ctx, position, pv, PONDER_MAX_PV);
+    SearchContext predictor = NULL;
+
+    for (int i = 0; GameState_getCurrentTurn(position) == opponent && !GameState_isTerminal(position); i++) {
+        int move;
+
+        if (i < length) {
+            move = pv[i];
+        } else {
+            if (predictor == NULL) predictor = new_SearchContext(PONDER_PREDICT_TABLE_ENTRIES);
+            if (predictor == NULL) return false;
+            move = SearchContext_iterDep(predictor, position, 0, PONDER_PREDICT_DEPTH, customHeuristic);
+        }
+
+        GameState_moveInto(position, move, position);
+    }
+
+    SearchContext_free(predictor);
+    return !GameState_isTerminal(position);
+}
+
+/**
+ * Whether the background search is on a position.
+ */
+static bool samePosition(GameState a, GameState b) {
+    return GameState_getHash(a) == GameState_getHash(b)
+        && a->ply == b->ply
+        && a->currentTurn == b->currentTurn;
+}
+
+
+Ponder new_Ponder(SearchContext ctx) {
+    if (ctx == NULL) return NULL;
+
+    struct Ponder* const newPonder = (Ponder)calloc(1, sizeof(struct Ponder));
+    if (newPonder == NULL) return NULL;
+
+    newPonder->ctx = ctx;
+    atomic_init(&newPonder->stop, false);
+    pthread_mutex_init(&newPonder->lock, NULL);
+    pthread_cond_init(&newPonder->done, NULL);
+
+    // What the background search learns is only useful if the table survives it.
+    SearchContext_setKeepTable(ctx, true);
+    SearchContext_setStopFlag(ctx, &newPonder->stop);
+
+    return newPonder;
+}
+
+void Ponder_free(Ponder ponder) {
+    if (ponder == NULL) return;
+
+    Ponder_stop(ponder);
+    SearchContext_setStopFlag(ponder->ctx, NULL);
+
+    pthread_mutex_destroy(&ponder->lock);
+    pthread_cond_destroy(&ponder->done);
+    free(ponder);
+}
+
+bool Ponder_start(Ponder ponder, GameState state, const int maxDepth, Heuristic customHeuristic) {
+    if (ponder == NULL || state == NULL) return false;
+    Ponder_stop(ponder);
+
+    ponder->position = *state;
+    if (!predictReply(ponder, &ponder->position, customHeuristic)) return false;
+
+    ponder->maxDepth = maxDepth;
+    ponder->h = customHeuristic;
+    ponder->finished = false;
+    atomic_store(&ponder->stop, false);
+
+    ponder->running = pthread_create(&ponder->thread, NULL, ponderThread, ponder) == 0;
+    return ponder->running;
+}
+
+int Ponder_respond(
+    Ponder ponder,
+    GameState state,
+    const time_t timeLimit,
+    const int maxDepth,
+    Heuristic customHeuristic)
+{
+    if (ponder == NULL || state == NULL) return -2;
+
+    ponder->hit = ponder->running
+        && samePosition(&ponder->position, state)
+        && ponder->maxDepth == maxDepth
+        && ponder->h == customHeuristic;
+
+    if (!ponder->hit) {
+        Ponder_stop(ponder);
+        atomic_store(&ponder->stop, false);
+        return SearchContext_iterDep(ponder->ctx, state, timeLimit, maxDepth, customHeuristic);
+    }
+
+    // The prediction was right: give the running search the time it would have had.
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeLimit / 1000;
+    deadline.tv_nsec += (long)(timeLimit % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    // Without a time limit, it runs to its maximum depth.
+    pthread_mutex_lock(&ponder->lock);
+    while (!ponder->finished) {
+        if (timeLimit <= 0) pthread_cond_wait(&ponder->done, &ponder->lock);
+        else if (pthread_cond_timedwait(&ponder->done, &ponder->lock, &deadline) == ETIMEDOUT) break;
+    }
+    pthread_mutex_unlock(&ponder->lock);
+
+    Ponder_stop(ponder);
+    atomic_store(&ponder->stop, false);
+    return ponder->move;
+}
+
+void Ponder_stop(Ponder ponder) {
+    if (ponder == NULL || !ponder->running) return;
+
+    atomic_store(&ponder->stop, true);
+    pthread_join(ponder->thread, NULL);
+    ponder->running = false;
+}
+
+bool Ponder_wasHit(Ponder ponder) {
+    if (ponder == NULL) return false;
+    return ponder->hit;
+}
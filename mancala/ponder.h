@@ -0,0 +1,83 @@
+/*
+ * project:  Mancalamax
+ * file:     ponder.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef PONDER_H
+#define PONDER_H
+
+#include <stdbool.h>
+#include <time.h>
+#include "state.h"
+#include "minimax.h"
+
+/**
+ * Searches on the opponent's time.
+ *
+ * Once the engine has moved, Ponder_start predicts the opponent's reply and
+ * searches the position it leads to in a background thread. When the engine
+ * is to move again, Ponder_respond either lets that search run on (if the
+ * prediction was right), or stops it and searches the actual position with
+ * the table it filled.
+ *
+ * A Ponder uses a SearchContext it does not own. It keeps the context's table
+ * between searches, and takes over its stop flag; the context must not be used
+ * by anything else while a search is running.
+ */
+typedef struct Ponder* Ponder;
+
+/**
+ * Create a new Ponder for a search context.
+ *
+ * @param ctx The context to search with
+ * @return A pointer to the new Ponder, or NULL if allocation failed
+ */
+extern Ponder new_Ponder(SearchContext ctx);
+
+/**
+ * Stop any background search and free the memory used by a Ponder.
+ */
+extern void Ponder_free(Ponder ponder);
+
+/**
+ * Start searching on the opponent's time. The opponent's reply is predicted
+ * from the table (the previous search's principal variation), or by a short
+ * search when the table has none, through any extra turns it earns.
+ *
+ * @param ponder The Ponder
+ * @param state The position after the engine's move, with the opponent to move
+ * @param maxDepth The maximum depth to search
+ * @param customHeuristic The heuristic function to use. Can be NULL to use the default.
+ * @return Whether a background search was started
+ */
+extern bool Ponder_start(Ponder ponder, GameState state, int maxDepth, Heuristic customHeuristic);
+
+/**
+ * Choose the engine's move once the opponent has replied. If the background
+ * search is on this position, it continues for up to timeLimit more; otherwise
+ * it is stopped and the position is searched for timeLimit. Search statistics
+ * are left in the context.
+ *
+ * @param ponder The Ponder
+ * @param state The position, with the engine to move
+ * @param timeLimit The time (in ms) from now to decide in (0 for no limit)
+ * @param maxDepth The maximum depth to search
+ * @param customHeuristic The heuristic function to use. Can be NULL to use the default.
+ * @return The move to play
+ */
+extern int Ponder_respond(Ponder ponder, GameState state, time_t timeLimit, int maxDepth, Heuristic customHeuristic);
+
+/**
+ * Stop the background search, if any, and wait for it to end.
+ */
+extern void Ponder_stop(Ponder ponder);
+
+/**
+ * Returns whether the last Ponder_respond continued a background search.
+ */
+extern bool Ponder_wasHit(Ponder ponder);
+
+
+#endif //PONDER_H
@@ -0,0 +1,460 @@
+/*
+ * project:  Mancalamax
+ * file:     scheduler.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "scheduler.h"
+#include "ttable.h"
+
+
+/**
+ * A search job, from submission until its result is delivered.
+ */
+typedef struct SchedulerJob {
+    long id;
+    struct GameState state;
+    double submitted;   // ms, monotonic clock
+    double deadline;    // ms, monotonic clock
+    int maxDepth;
+    Heuristic h;
+    size_t memoryLimit;
+    SchedulerCallback callback;
+    void* data;
+} SchedulerJob;
+
+/**
+ * A worker's queue: a binary heap of jobs, earliest deadline first.
+ */
+typedef struct JobQueue {
+    SchedulerJob** jobs;
+    size_t size;
+    size_t capacity;
+    pthread_mutex_t lock;
+} JobQueue;
+
+/**
+ * A result waiting in the completion queue.
+ */
+typedef struct CompletedJob {
+    SchedulerResult result;
+    struct CompletedJob* next;
+} CompletedJob;
+
+/**
+ * A worker thread, with its queue and its search context.
+ */
+typedef struct Worker {
+    struct Scheduler* scheduler;
+    int index;
+    pthread_t thread;
+    JobQueue queue;
+    SearchContext ctx;
+    size_t tableEntries;
+} Worker;
+
+struct Scheduler {
+    Worker* workers;
+    int threads;
+    int started;
+
+    atomic_long nextId;
+    atomic_uint nextQueue;
+    atomic_size_t pending;
+
+    // Stops the running searches when the scheduler is freed.
+    atomic_bool stop;
+
+    // Idle workers wait here for jobs. `queued` counts jobs not yet taken.
+    pthread_mutex_t idleLock;
+    pthread_cond_t idleCond;
+    size_t queued;
+    bool shutdown;
+
+    // Results of jobs without a callback, oldest first.
+    pthread_mutex_t doneLock;
+    pthread_cond_t doneCond;
+    CompletedJob* doneHead;
+    CompletedJob* doneTail;
+};
+
+/**
+ * Helper function to read the monotonic clock in ms.
+ */
+static double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+/**
+ * Whether job a is more urgent than job b. Equal deadlines run in submission order.
+ */
+static bool moreUrgent(const SchedulerJob* a, const SchedulerJob* b) {
+    if (a->deadline != b->deadline) return a->deadline < b->deadline;
+    return a->id < b->id;
+}
+
+static bool JobQueue_push(JobQueue* queue, SchedulerJob* job) {
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->size == queue->capacity) {
+        const size_t capacity = queue->capacity == 0 ? 64 : queue->capacity * 2;
+        SchedulerJob** const jobs = (SchedulerJob**)realloc(queue->jobs, sizeof(SchedulerJob*) * capacity);
+        if (jobs == NULL) {
+            pthread_mutex_unlock(&queue->lock);
+            return false;
+        }
+
+        queue->jobs = jobs;
+        queue->capacity = capacity;
+    }
+
+    // Sift up.
+    size_t i = queue->size++;
+    while (i > 0 && moreUrgent(job, queue->jobs[(i - 1) / 2])) {
+        queue->jobs[i] = queue->jobs[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    queue->jobs[i] = job;
+
+    pthread_mutex_unlock(&queue->lock);
+    return true;
+}
+
+/**
+ * Remove the most urgent job of a queue. The queue must be locked and not empty.
+ */
+static SchedulerJob* JobQueue_popLocked(JobQueue* queue) {
+    SchedulerJob* const top = queue->jobs[0];
+    SchedulerJob* const last = queue->jobs[--queue->size];
+
+    // Sift down.
+    size_t i = 0;
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= queue->size) break;
+        if (child + 1 < queue->size && moreUrgent(queue->jobs[child + 1], queue->jobs[child])) child++;
+        if (!moreUrgent(queue->jobs[child], last)) break;
+
+        queue->jobs[i] = queue->jobs[child];
+        i = child;
+    }
+    if (queue->size > 0) queue->jobs[i] = last;
+
+    return top;
+}
+
+/**
+ * Take a job for a worker: the most urgent job of its own queue, or else the
+ * most urgent job of another queue.
+ */
+static SchedulerJob* takeJob(Worker* worker) {
+    Scheduler const scheduler = worker->scheduler;
+    SchedulerJob* job = NULL;
+
+    pthread_mutex_lock(&worker->queue.lock);
+    if (worker->queue.size > 0) job = JobQueue_popLocked(&worker->queue);
+    pthread_mutex_unlock(&worker->queue.lock);
+    if (job != NULL) return job;
+
+    // Find the victim with the most urgent job, then steal it if it is still there.
+    JobQueue* victim = NULL;
+    double earliest = 0;
+
+    for (int i = 1; i < scheduler->threads; i++) {
+        JobQueue* const queue = &scheduler->workers[(worker->index + i) % scheduler->threads].queue;
+
+        pthread_mutex_lock(&queue->lock);
+        if (queue->size > 0 && (victim == NULL || queue->jobs[0]->deadline < earliest)) {
+            victim = queue;
+            earliest = queue->jobs[0]->deadline;
+        }
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    if (victim == NULL) return NULL;
+
+    pthread_mutex_lock(&victim->lock);
+    if (victim->size > 0) job = JobQueue_popLocked(victim);
+    pthread_mutex_unlock(&victim->lock);
+    return job;
+}
+
+/**
+ * Hand a result to its job's callback, or to the completion queue.
+ */
+static void deliver(Scheduler scheduler, SchedulerJob* job, const SchedulerResult* result) {
+    CompletedJob* completed = NULL;
+
+    if (job->callback != NULL) {
+        job->callback(result, job->data);
+    } else {
+        completed = (CompletedJob*)malloc(sizeof(CompletedJob));
+        if (completed != NULL) {
+            completed->result = *result;
+            completed->next = NULL;
+        }
+    }
+
+    pthread_mutex_lock(&scheduler->doneLock);
+    if (completed != NULL) {
+        if (scheduler->doneTail != NULL) scheduler->doneTail->next = completed;
+        else scheduler->doneHead = completed;
+        scheduler->doneTail = completed;
+    }
+
+    atomic_fetch_sub(&scheduler->pending, 1);
+    pthread_cond_broadcast(&scheduler->doneCond);
+    pthread_mutex_unlock(&scheduler->doneLock);
+}
+
+/**
+ * Returns the table entries that fit in a job's memory limit, next to the
+ * scratch memory of a search to its depth (0 if none do).
+ */
+static size_t tableEntriesFor(const size_t memoryLimit, const int maxDepth) {
+    const size_t scratch = SearchContext_getScratchBytes(maxDepth);
+    return memoryLimit > scratch ? TTable_entriesForBytes(memoryLimit - scratch) : 0;
+}
+
+/**
+ * Search a job with the worker's context, within the time left before its deadline.
+ */
+static void runJob(Worker* worker, SchedulerJob* job) {
+    SearchContext const ctx = worker->ctx;
+
+    // Size the table to what the job's memory limit leaves after the search's
+    // scratch memory. It is only reallocated when the size changes.
+    const size_t entries = job->memoryLimit == 0
+        ? MINIMAX_DEFAULT_TABLE_ENTRIES
+        : tableEntriesFor(job->memoryLimit, job->maxDepth);
+    if (entries != worker->tableEntries) {
+        SearchContext_setTableSize(ctx, entries);
+        worker->tableEntries = entries;
+    }
+
+    // A job that starts late still gets the shortest search, rather than no move.
+    const double start = nowMs();
+    const double remaining = job->deadline - start;
+    const time_t timeLimit = isinf(remaining) ? 0 : remaining >= 1 ? (time_t)remaining : 1;
+
+    SchedulerResult result;
+    result.id = job->id;
+    result.move = SearchContext_iterDep(ctx, &job->state, timeLimit, job->maxDepth, job->h);
+    result.late = remaining <= 0;
+    result.waitTime = start - job->submitted;
+    result.searchTime = nowMs() - start;
+
+    SearchStats stats;
+    SearchContext_getStats(ctx, &stats);
+    result.score = stats.score;
+    result.depth = stats.completedDepth;
+    result.nodes = stats.nodes;
+    result.aborted = stats.aborted;
+
+    deliver(worker->scheduler, job, &result);
+}
+
+/**
+ * Worker thread: run jobs until the scheduler is freed.
+ */
+static void* workerThread(void* arg) {
+    Worker* const worker = (Worker*)arg;
+    Scheduler const scheduler = worker->scheduler;
+
+    while (true) {
+        // Claim one of the queued jobs, then find it.
+        pthread_mutex_lock(&scheduler->idleLock);
+        while (scheduler->queued == 0 && !scheduler->shutdown)
+            pthread_cond_wait(&scheduler->idleCond, &scheduler->idleLock);
+
+        if (scheduler->shutdown) {
+            pthread_mutex_unlock(&scheduler->idleLock);
+            break;
+        }
+
+        scheduler->queued--;
+        pthread_mutex_unlock(&scheduler->idleLock);
+
+        // Every claim matches a queued job, so one is found (maybe after another
+        // worker has taken the first one looked at).
+        SchedulerJob* job;
+        while ((job = takeJob(worker)) == NULL) sched_yield();
+
+        runJob(worker, job);
+        free(job);
+    }
+
+    return NULL;
+}
+
+
+Scheduler new_Scheduler(int threads) {
+    if (threads < 1) threads = 1;
+
+    struct Scheduler* const newScheduler = (Scheduler)calloc(1, sizeof(struct Scheduler));
+    if (newScheduler == NULL) return NULL;
+
+    newScheduler->workers = (Worker*)calloc(threads, sizeof(Worker));
+    if (newScheduler->workers == NULL) {
+        free(newScheduler);
+        return NULL;
+    }
+
+    atomic_init(&newScheduler->nextId, 1);
+    atomic_init(&newScheduler->nextQueue, 0);
+    atomic_init(&newScheduler->pending, 0);
+    atomic_init(&newScheduler->stop, false);
+    pthread_mutex_init(&newScheduler->idleLock, NULL);
+    pthread_cond_init(&newScheduler->idleCond, NULL);
+    pthread_mutex_init(&newScheduler->doneLock, NULL);
+    pthread_cond_init(&newScheduler->doneCond, NULL);
+
+    // Tables are allocated by the first search, at the size of its job's limit.
+    for (int i = 0; i < threads; i++) {
+        Worker* const worker = &newScheduler->workers[i];
+        worker->scheduler = newScheduler;
+        worker->index = i;
+        worker->tableEntries = MINIMAX_DEFAULT_TABLE_ENTRIES;
+        pthread_mutex_init(&worker->queue.lock, NULL);
+
+        worker->ctx = new_SearchContext(worker->tableEntries);
+        if (worker->ctx != NULL) SearchContext_setStopFlag(worker->ctx, &newScheduler->stop);
+    }
+
+    // Start the workers once every queue exists, as they steal from each other.
+    newScheduler->threads = threads;
+    for (; newScheduler->started < threads; newScheduler->started++) {
+        Worker* const worker = &newScheduler->workers[newScheduler->started];
+        if (worker->ctx == NULL || pthread_create(&worker->thread, NULL, workerThread, worker) != 0) break;
+    }
+
+    if (newScheduler->started < threads) {
+        Scheduler_free(newScheduler);
+        return NULL;
+    }
+
+    return newScheduler;
+}
+
+void Scheduler_free(Scheduler scheduler) {
+    if (scheduler == NULL) return;
+
+    pthread_mutex_lock(&scheduler->idleLock);
+    scheduler->shutdown = true;
+    pthread_cond_broadcast(&scheduler->idleCond);
+    pthread_mutex_unlock(&scheduler->idleLock);
+
+    atomic_store(&scheduler->stop, true);
+
+    for (int i = 0; i < scheduler->started; i++) pthread_join(scheduler->workers[i].thread, NULL);
+
+    // Drop the jobs that never started.
+    for (int i = 0; i < scheduler->threads; i++) {
+        Worker* const worker = &scheduler->workers[i];
+        for (size_t j = 0; j < worker->queue.size; j++) free(worker->queue.jobs[j]);
+
+        free(worker->queue.jobs);
+        pthread_mutex_destroy(&worker->queue.lock);
+        SearchContext_free(worker->ctx);
+    }
+
+    while (scheduler->doneHead != NULL) {
+        CompletedJob* const next = scheduler->doneHead->next;
+        free(scheduler->doneHead);
+        scheduler->doneHead = next;
+    }
+
+    pthread_mutex_destroy(&scheduler->idleLock);
+    pthread_cond_destroy(&scheduler->idleCond);
+    pthread_mutex_destroy(&scheduler->doneLock);
+    pthread_cond_destroy(&scheduler->doneCond);
+
+    free(scheduler->workers);
+    free(scheduler);
+}
+
+long Scheduler_submit(
+    Scheduler scheduler,
+    GameState state,
+    const time_t timeLimit,
+    const int maxDepth,
+    Heuristic customHeuristic,
+    const size_t memoryLimit,
+    SchedulerCallback callback,
+    void* data)
+{
+    if (scheduler == NULL || state == NULL || maxDepth < 1) return -1;
+
+    // A limit too small to hold a table (next to the scratch memory) is rejected,
+    // rather than silently searching without one.
+    if (memoryLimit != 0 && tableEntriesFor(memoryLimit, maxDepth) == 0) return -1;
+
+    SchedulerJob* const job = (SchedulerJob*)malloc(sizeof(SchedulerJob));
+    if (job == NULL) return -1;
+
+    const long id = atomic_fetch_add(&scheduler->nextId, 1);
+    job->id = id;
+    job->state = *state;
+    job->submitted = nowMs();
+    job->deadline = timeLimit > 0 ? job->submitted + (double)timeLimit : INFINITY;
+    job->maxDepth = maxDepth;
+    job->h = customHeuristic;
+    job->memoryLimit = memoryLimit;
+    job->callback = callback;
+    job->data = data;
+
+    // Spread jobs over the queues; idle workers steal from busy ones.
+    const unsigned int queue = atomic_fetch_add(&scheduler->nextQueue, 1) % (unsigned int)scheduler->threads;
+    atomic_fetch_add(&scheduler->pending, 1);
+
+    if (!JobQueue_push(&scheduler->workers[queue].queue, job)) {
+        atomic_fetch_sub(&scheduler->pending, 1);
+        free(job);
+        return -1;
+    }
+
+    pthread_mutex_lock(&scheduler->idleLock);
+    scheduler->queued++;
+    pthread_cond_signal(&scheduler->idleCond);
+    pthread_mutex_unlock(&scheduler->idleLock);
+
+    // A worker may already have run and freed the job.
+    return id;
+}
+
+bool Scheduler_takeResult(Scheduler scheduler, SchedulerResult* result, const bool wait) {
+    if (scheduler == NULL || result == NULL) return false;
+
+    pthread_mutex_lock(&scheduler->doneLock);
+
+    // Only wait while some job could still add a result.
+    while (wait && scheduler->doneHead == NULL && atomic_load(&scheduler->pending) > 0)
+        pthread_cond_wait(&scheduler->doneCond, &scheduler->doneLock);
+
+    CompletedJob* const completed = scheduler->doneHead;
+    if (completed != NULL) {
+        scheduler->doneHead = completed->next;
+        if (scheduler->doneHead == NULL) scheduler->doneTail = NULL;
+    }
+
+    pthread_mutex_unlock(&scheduler->doneLock);
+
+    if (completed == NULL) return false;
+    *result = completed->result;
+    free(completed);
+    return true;
+}
+
+size_t Scheduler_getPending(Scheduler scheduler) {
+    if (scheduler == NULL) return 0;
+    return atomic_load(&scheduler->pending);
+}
@@ -0,0 +1,102 @@
+/*
+ * project:  Mancalamax
+ * file:     scheduler.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include "state.h"
+#include "minimax.h"
+
+/**
+ * Runs search jobs for many games at once on a fixed pool of threads.
+ *
+ * Every worker thread has its own queue, ordered by deadline (earliest
+ * first), and its own SearchContext. Jobs are spread over the queues, and a
+ * worker whose queue is empty steals the most urgent job of another. Results
+ * are passed to a job's callback, or put on a completion queue.
+ */
+typedef struct Scheduler* Scheduler;
+
+/**
+ * The result of a search job.
+ */
+typedef struct SchedulerResult {
+    long id;              // the job's id, from Scheduler_submit
+    int move;             // the best move found
+    double score;         // score of the move, for the player to move
+    int depth;            // deepest completed search depth
+    size_t nodes;         // nodes visited
+    bool aborted;         // whether the last iteration was stopped by the deadline
+    bool late;            // whether the job started after its deadline
+    double waitTime;      // time (in ms) spent in the queue
+    double searchTime;    // time (in ms) spent searching
+} SchedulerResult;
+
+/**
+ * Typedef representing a function that receives the result of a job, on the
+ * worker thread that ran it.
+ */
+typedef void (*SchedulerCallback)(const SchedulerResult* result, void* data);
+
+/**
+ * Create a new Scheduler, and start its worker threads.
+ *
+ * @param threads The number of worker threads (at least 1)
+ * @return A pointer to the new Scheduler, or NULL if it could not be started
+ */
+extern Scheduler new_Scheduler(int threads);
+
+/**
+ * Stop a Scheduler and free its memory. Running searches are stopped and
+ * report their best move so far; jobs that have not started are dropped.
+ */
+extern void Scheduler_free(Scheduler scheduler);
+
+/**
+ * Submit a search job. The state is copied, so it can be changed or freed
+ * right away.
+ *
+ * @param scheduler The Scheduler to run the job
+ * @param state The state to search
+ * @param timeLimit The time (in ms) from now by which the result is needed (0 for no deadline)
+ * @param maxDepth The maximum depth to search
+ * @param customHeuristic The heuristic function to use. Can be NULL to use the default.
+ * @param memoryLimit The most memory (in bytes) the job's table and search scratch may use together (0 for the default)
+ * @param callback The function to pass the result to, or NULL to put it on the completion queue
+ * @param data Passed to the callback
+ * @return The id of the job, or -1 if it could not be submitted (or its memory limit cannot hold a table)
+ */
+extern long Scheduler_submit(
+    Scheduler scheduler,
+    GameState state,
+    time_t timeLimit,
+    int maxDepth,
+    Heuristic customHeuristic,
+    size_t memoryLimit,
+    SchedulerCallback callback,
+    void* data);
+
+/**
+ * Take the next result from the completion queue, waiting for one if needed.
+ *
+ * @param scheduler The Scheduler
+ * @param result Set to the result
+ * @param wait Whether to wait for a result if none is ready
+ * @return Whether a result was taken
+ */
+extern bool Scheduler_takeResult(Scheduler scheduler, SchedulerResult* result, bool wait);
+
+/**
+ * Returns the number of jobs submitted that have not finished yet.
+ */
+extern size_t Scheduler_getPending(Scheduler scheduler);
+
+
+#endif //SCHEDULER_H
@@ -0,0 +1,299 @@
+/*
+ * project:  Mancalamax
+ * file:     selfplay.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "selfplay.h"
+#include "state.h"
+#include "minimax.h"
+
+
+#define SELFPLAY_MAGIC "MNCLPLAY"
+#define SELFPLAY_VERSION 1
+
+// Records buffered by a thread before they are appended to the file (about 1 MiB).
+#define SELFPLAY_BLOCK_RECORDS ((size_t)(1 << 20) / sizeof(SelfPlayRecord))
+
+// Depth limit of searches that only have a time limit.
+#define SELFPLAY_UNLIMITED_DEPTH 1000
+
+/**
+ * The header at the start of a self-play file.
+ */
+typedef struct SelfPlayHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pits;
+    uint32_t stones;
+    uint32_t depth;
+    uint64_t records;
+} SelfPlayHeader;
+
+_Static_assert(sizeof(SelfPlayHeader) == 32, "self-play header must be 32 bytes");
+_Static_assert(sizeof(SelfPlayRecord) == 48, "self-play record must be 48 bytes");
+
+/**
+ * A growable array of records, used for the positions of the game being played.
+ */
+typedef struct RecordList {
+    SelfPlayRecord* records;
+    size_t size;
+    size_t capacity;
+} RecordList;
+
+/**
+ * Shared state of the threads playing the games of a run. The lock guards
+ * the file and the counters below it.
+ */
+typedef struct SelfPlayRun {
+    const SelfPlayOptions* options;
+    int depth;
+    atomic_int next;
+
+    pthread_mutex_t lock;
+    FILE* file;
+    bool failed;
+    uint64_t records;
+    size_t wins[2];
+    size_t draws;
+} SelfPlayRun;
+
+static bool RecordList_append(RecordList* list, const SelfPlayRecord* record) {
+    if (list->size == list->capacity) {
+        const size_t capacity = list->capacity == 0 ? 256 : list->capacity * 2;
+        SelfPlayRecord* const records = (SelfPlayRecord*)realloc(list->records, sizeof(SelfPlayRecord) * capacity);
+        if (records == NULL) return false;
+
+        list->records = records;
+        list->capacity = capacity;
+    }
+
+    list->records[list->size++] = *record;
+    return true;
+}
+
+/**
+ * Append records to the file, as one write. Only records that were written
+ * are counted; after a failed write, nothing more is.
+ */
+static void writeRecords(SelfPlayRun* run, const SelfPlayRecord* records, const size_t count) {
+    if (count == 0) return;
+
+    pthread_mutex_lock(&run->lock);
+    if (!run->failed) {
+        const size_t written = fwrite(records, sizeof(SelfPlayRecord), count, run->file);
+        run->records += written;
+        if (written != count) run->failed = true;
+    }
+    pthread_mutex_unlock(&run->lock);
+}
+
+/**
+ * Fill in a record for a position before its search's move is played. Moves
+ * are numbered from 1 by the search, and from 0 in records.
+ */
+static void describePosition(SelfPlayRecord* record, GameState state, SearchContext ctx, const int move) {
+    memset(record, 0, sizeof(*record));
+
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i < state->pits; i++) record->pits[player][i] = (uint8_t)state->players[player][i];
+        record->stores[player] = (uint16_t)state->stores[player];
+    }
+
+    const int depth = SearchContext_getCompletedDepth(ctx);
+    record->ply = (uint16_t)state->ply;
+    record->turn = (uint8_t)GameState_getCurrentTurn(state);
+    record->move = (int8_t)(move > 0 ? move - 1 : move);
+    record->score = (float)SearchContext_getScore(ctx);
+    record->depth = (uint8_t)(depth > UINT8_MAX ? UINT8_MAX : depth);
+}
+
+/**
+ * Play one game, and collect its searched positions with their outcomes.
+ *
+ * @param difference Set to the final store difference for player 0
+ * @return Whether the game was played (false if memory ran out)
+ */
+static bool playGame(SelfPlayRun* run, SearchContext ctx, const int game, RecordList* positions, int* difference) {
+    const SelfPlayOptions* const options = run->options;
+    GameState state = GameState_initCustom(options->pits, options->stones);
+    if (state == NULL) return false;
+
+    // Spread neighbouring games' seeds apart, so their openings are unrelated.
+    unsigned int seed = (options->seed + (unsigned int)game) * 2654435761u;
+    bool ok = true;
+
+    SearchContext_newGame(ctx);
+    positions->size = 0;
+
+    for (int plies = 0; ok && !GameState_isTerminal(state); plies++) {
+        int move;
+
+        if (plies < options->randomPlies) {
+            MoveList moves;
+            GameState_generateMoves(state, &moves);
+            move = moves.moves[rand_r(&seed) % moves.size];
+        } else {
+            move = SearchContext_iterDep(ctx, state, options->timeLimit, run->depth, options->heuristic);
+
+            SelfPlayRecord record;
+            describePosition(&record, state, ctx, move);
+            ok = RecordList_append(positions, &record);
+        }
+
+        GameState_moveInto(state, move, state);
+    }
+
+    *difference = GameState_getScore(state, 0) - GameState_getScore(state, 1);
+    GameState_free(state);
+
+    for (size_t i = 0; i < positions->size; i++)
+        positions->records[i].result = (int16_t)(positions->records[i].turn == 0 ? *difference : -*difference);
+
+    return ok;
+}
+
+/**
+ * Player thread: play games until none are left, and append their records to
+ * the file a block at a time. A game's records are never split between blocks.
+ */
+static void* selfPlayThread(void* arg) {
+    SelfPlayRun* const run = (SelfPlayRun*)arg;
+    const SelfPlayOptions* const options = run->options;
+
+    SearchContext ctx = new_SearchContext(options->tableEntries > 0 ? options->tableEntries : MINIMAX_DEFAULT_TABLE_ENTRIES);
+    SelfPlayRecord* const block = (SelfPlayRecord*)malloc(sizeof(SelfPlayRecord) * SELFPLAY_BLOCK_RECORDS);
+    RecordList positions = {NULL, 0, 0};
+    size_t buffered = 0;
+    bool ok = ctx != NULL && block != NULL;
+
+    // Positions of a game are searched one after another, so each search can
+    // start from what the previous one left in the table.
+    SearchContext_setKeepTable(ctx, true);
+
+    while (ok) {
+        const int game = atomic_fetch_add(&run->next, 1);
+        if (game >= options->games) break;
+
+        int difference;
+        ok = playGame(run, ctx, game, &positions, &difference);
+        if (!ok) break;
+
+        if (buffered + positions.size > SELFPLAY_BLOCK_RECORDS) {
+            writeRecords(run, block, buffered);
+            buffered = 0;
+        }
+
+        if (positions.size > SELFPLAY_BLOCK_RECORDS) {
+            writeRecords(run, positions.records, positions.size);
+        } else {
+            memcpy(block + buffered, positions.records, sizeof(SelfPlayRecord) * positions.size);
+            buffered += positions.size;
+        }
+
+        pthread_mutex_lock(&run->lock);
+        if (difference > 0) run->wins[0]++;
+        else if (difference < 0) run->wins[1]++;
+        else run->draws++;
+        pthread_mutex_unlock(&run->lock);
+    }
+
+    if (ok) {
+        writeRecords(run, block, buffered);
+    } else {
+        pthread_mutex_lock(&run->lock);
+        run->failed = true;
+        pthread_mutex_unlock(&run->lock);
+    }
+
+    free(positions.records);
+    free(block);
+    SearchContext_free(ctx);
+    return NULL;
+}
+
+
+long SelfPlay_generate(const char* path, const SelfPlayOptions* options, SelfPlayStats* stats) {
+    if (path == NULL || options == NULL || options->games < 0) return -1;
+
+    // Fill in the defaults.
+    SelfPlayOptions settings = *options;
+    if (settings.pits == 0) settings.pits = 6;
+    if (settings.stones == 0) settings.stones = 4;
+    if (settings.threads < 1) settings.threads = 1;
+
+    if (settings.pits < 1 || settings.pits > GAMESTATE_MAX_PITS || settings.stones < 1
+        || 2 * settings.pits * settings.stones > SELFPLAY_MAX_STONES
+        || settings.depth < 0 || settings.timeLimit < 0 || (settings.depth == 0 && settings.timeLimit == 0)) {
+        return -1;
+    }
+
+    SelfPlayRun run;
+    run.options = &settings;
+    run.depth = settings.depth > 0 ? settings.depth : SELFPLAY_UNLIMITED_DEPTH;
+    atomic_init(&run.next, 0);
+    pthread_mutex_init(&run.lock, NULL);
+    run.failed = false;
+    run.records = 0;
+    run.wins[0] = run.wins[1] = 0;
+    run.draws = 0;
+
+    // The header is written again with the number of records at the end.
+    SelfPlayHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SELFPLAY_MAGIC, sizeof(header.magic));
+    header.version = SELFPLAY_VERSION;
+    header.pits = (uint32_t)settings.pits;
+    header.stones = (uint32_t)settings.stones;
+    header.depth = (uint32_t)settings.depth;
+
+    run.file = fopen(path, "wb");
+    pthread_t* const workers = (pthread_t*)malloc(sizeof(pthread_t) * settings.threads);
+    if (run.file == NULL || workers == NULL || fwrite(&header, sizeof(header), 1, run.file) != 1) {
+        if (run.file != NULL) fclose(run.file);
+        free(workers);
+        pthread_mutex_destroy(&run.lock);
+        return -1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Play the games on all threads.
+    int started = 0;
+    for (; started < settings.threads - 1; started++) {
+        if (pthread_create(&workers[started], NULL, selfPlayThread, &run) != 0) break;
+    }
+
+    selfPlayThread(&run);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    free(workers);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    header.records = run.records;
+    bool written = !run.failed
+        && fseek(run.file, 0, SEEK_SET) == 0
+        && fwrite(&header, sizeof(header), 1, run.file) == 1;
+    if (fclose(run.file) != 0) written = false;
+    pthread_mutex_destroy(&run.lock);
+
+    if (stats != NULL) {
+        stats->games = run.wins[0] + run.wins[1] + run.draws;
+        stats->positions = run.records;
+        stats->wins[0] = run.wins[0];
+        stats->wins[1] = run.wins[1];
+        stats->draws = run.draws;
+        stats->time = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+
+    return written ? (long)run.records : -1;
+}
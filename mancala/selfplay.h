@@ -0,0 +1,88 @@
+/*
+ * project:  Mancalamax
+ * file:     selfplay.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <stdint.h>
+#include <time.h>
+#include "state.h"
+#include "minimax.h"
+
+/**
+ * The most stones a self-play variant may have in total, so that any pit's
+ * count fits in a record's uint8.
+ */
+#define SELFPLAY_MAX_STONES 255
+
+/**
+ * Self-play training data: positions from engine-against-engine games, each
+ * labelled with the search's score and the game's outcome.
+ *
+ * File layout (native byte order):
+ *   - A 32 byte header: magic "MNCLPLAY", uint32 version, uint32 pits,
+ *     uint32 stones per pit, uint32 search depth, and uint64 records.
+ *   - 48 byte records (SelfPlayRecord), one per searched position. The
+ *     records of a game are contiguous and in move order; games are in the
+ *     order they finished.
+ *
+ * Positions played at random to open a game are not recorded.
+ */
+typedef struct SelfPlayRecord {
+    uint8_t pits[2][GAMESTATE_MAX_PITS];  // stones in each pit, by player (unused pits are 0)
+    uint16_t stores[2];                   // stones in each store, by player
+    uint16_t ply;                         // game ply of the position
+    uint8_t turn;                         // player to move
+    int8_t move;                          // move played: index into pits[turn] (the pit number minus 1), or -1 for "PIE"
+    float score;                          // search score, for the player to move
+    int16_t result;                       // final store difference, for the player to move
+    uint8_t depth;                        // depth the search completed
+    uint8_t reserved;
+} SelfPlayRecord;
+
+/**
+ * Settings of a self-play run. Fields left 0 take the defaults noted.
+ */
+typedef struct SelfPlayOptions {
+    int pits;             // pits per player (6)
+    int stones;           // stones per pit at the start (4)
+    int games;            // number of games to play
+    int depth;            // depth limit of each search (none, if there is a time limit)
+    time_t timeLimit;     // time limit of each search in milliseconds (none, if there is a depth limit)
+    int randomPlies;      // plies played uniformly at random to open each game (none)
+    int threads;          // games played at once, one per thread (1)
+    size_t tableEntries;  // transposition table entries per thread (MINIMAX_DEFAULT_TABLE_ENTRIES)
+    unsigned int seed;    // seed of the random openings; game g uses seed + g
+    Heuristic heuristic;  // heuristic of the searches (the default heuristic)
+} SelfPlayOptions;
+
+/**
+ * Statistics of a self-play run.
+ */
+typedef struct SelfPlayStats {
+    size_t games;
+    size_t positions;
+    size_t wins[2];  // games won by each player
+    size_t draws;
+    double time;     // wall-clock time in seconds
+} SelfPlayStats;
+
+/**
+ * Play games of the engine against itself on several threads, and write
+ * every searched position to a file. Each thread has its own search context,
+ * which keeps its table from move to move of a game, and buffers records in
+ * large blocks that are appended to the file whole.
+ *
+ * @param path The path of the file to write
+ * @param options The settings of the run
+ * @param stats Filled in with the statistics of the run (can be NULL)
+ * @return The number of records written, or -1 if the options are invalid or the file could not be written
+ */
+extern long SelfPlay_generate(const char* path, const SelfPlayOptions* options, SelfPlayStats* stats);
+
+
+#endif //SELFPLAY_H
@@ -0,0 +1,52 @@
+/*
+ * project:  Mancalamax
+ * file:     selfplay_gen.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "selfplay.h"
+
+
+/**
+ * Write a file of self-play training data.
+ *
+ * Usage: mancalamax_selfplay <file> <games> <depth> [ms] [random plies] [pits] [stones] [threads] [seed]
+ *
+ * A depth of 0 searches each position for the time limit alone.
+ */
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <file> <games> <depth> [ms] [random plies] [pits] [stones] [threads] [seed]\n", argv[0]);
+        return 2;
+    }
+
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    SelfPlayOptions options = {0};
+    options.games = atoi(argv[2]);
+    options.depth = atoi(argv[3]);
+    options.timeLimit = argc > 4 ? atoi(argv[4]) : 0;
+    options.randomPlies = argc > 5 ? atoi(argv[5]) : 4;
+    options.pits = argc > 6 ? atoi(argv[6]) : 6;
+    options.stones = argc > 7 ? atoi(argv[7]) : 4;
+    options.threads = argc > 8 ? atoi(argv[8]) : (cpus > 0 ? (int)cpus : 1);
+    options.seed = argc > 9 ? (unsigned int)strtoul(argv[9], NULL, 10) : 1;
+
+    SelfPlayStats stats;
+    const long records = SelfPlay_generate(argv[1], &options, &stats);
+    if (records < 0) {
+        fprintf(stderr, "could not generate %s (check the options)\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s: %zu games (%zu-%zu-%zu), %ld positions (%d pits, %d stones, depth %d, %d threads)\n",
+        argv[1], stats.games, stats.wins[0], stats.draws, stats.wins[1], records,
+        options.pits, options.stones, options.depth, options.threads);
+    printf("%.3f s, %.1f games/s, %.0f positions/s\n",
+        stats.time, stats.time > 0 ? stats.games / stats.time : 0, stats.time > 0 ? stats.positions / stats.time : 0);
+    return 0;
+}
@@ -0,0 +1,398 @@
+/*
+ * project:  Mancalamax
+ * file:     server.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "state.h"
+#include "minimax.h"
+
+
+#define SERVER_MAX_LINE 4096
+#define SERVER_MAX_PV 64
+
+// Depth limit of a search without one (it runs until stopped).
+#define SERVER_UNLIMITED_DEPTH 1000
+
+/**
+ * A long-lived engine, answering commands from one client at a time.
+ */
+typedef struct Server {
+    SearchContext ctx;
+    GameState position;
+    FILE* out;
+    pthread_mutex_t outLock;
+
+    // The background search, and the flag that stops it.
+    pthread_t searchThread;
+    bool searching;
+    atomic_bool stop;
+
+    // The root of the running search, and its limits.
+    GameState searchRoot;
+    time_t timeLimit;
+    int maxDepth;
+    int threads;
+} Server;
+
+/**
+ * Write a line to the client. Lines come from both the command loop and the
+ * search thread, so they are written whole, one at a time.
+ */
+static void reply(Server* server, const char* format, ...) {
+    pthread_mutex_lock(&server->outLock);
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(server->out, format, args);
+    va_end(args);
+
+    fputc('\n', server->out);
+    fflush(server->out);
+    pthread_mutex_unlock(&server->outLock);
+}
+
+/**
+ * Report a completed iteration: "info depth D score S nodes N time T pv M...".
+ * Helper threads are still running, so only the main thread's counts are used.
+ * The table can hold deeper lines than the iteration searched, so the PV is
+ * cut at the iteration's depth.
+ */
+static void reportIteration(SearchContext ctx, const SearchIteration* iteration, void* data) {
+    Server* const server = (Server*)data;
+
+    int pv[SERVER_MAX_PV];
+    const int maxLength = iteration->depth < SERVER_MAX_PV ? iteration->depth : SERVER_MAX_PV;
+    const int length = SearchContext_getPV(ctx, server->searchRoot, pv, maxLength);
+
+    char line[SERVER_MAX_LINE];
+    int used = snprintf(line, sizeof(line), "info depth %d score %g nodes %zu time %.0f pv",
+        iteration->depth, iteration->score, iteration->nodes, iteration->time);
+
+    for (int i = 0; i < length && used < (int)sizeof(line); i++)
+        used += snprintf(line + used, sizeof(line) - used, " %d", pv[i]);
+
+    reply(server, "%s", line);
+}
+
+/**
+ * Search thread: search the root, then report the best move.
+ */
+static void* searchThread(void* arg) {
+    Server* const server = (Server*)arg;
+
+    const int move = SearchContext_iterDepParallel(
+        server->ctx, server->searchRoot, server->timeLimit, server->maxDepth, NULL, server->threads);
+
+    reply(server, "bestmove %d", move);
+    return NULL;
+}
+
+/**
+ * Stop the running search (if any), and wait for its best move to be reported.
+ */
+static void stopSearch(Server* server) {
+    if (!server->searching) return;
+
+    atomic_store(&server->stop, true);
+    pthread_join(server->searchThread, NULL);
+    server->searching = false;
+
+    GameState_free(server->searchRoot);
+    server->searchRoot = NULL;
+}
+
+/**
+ * Wait for a search with limits to finish on its own.
+ */
+static void waitSearch(Server* server) {
+    if (!server->searching) return;
+
+    pthread_join(server->searchThread, NULL);
+    server->searching = false;
+
+    GameState_free(server->searchRoot);
+    server->searchRoot = NULL;
+}
+
+/**
+ * Apply moves to a position, from the tokens after "moves".
+ *
+ * @return Whether every move was legal
+ */
+static bool applyMoves(Server* server, GameState position, char** save) {
+    char* token;
+    while ((token = strtok_r(NULL, " \t", save)) != NULL) {
+        const int move = atoi(token);
+
+        MoveList validMoves;
+        GameState_generateMoves(position, &validMoves);
+        if (!MoveList_contains(&validMoves, move)) {
+            reply(server, "info string illegal move %s", token);
+            return false;
+        }
+
+        GameState_moveInto(position, move, position);
+    }
+
+    return true;
+}
+
+/**
+ * Whether the stone counts, ply and turn of a "position board" are valid.
+ */
+static bool validBoard(const int* values, const int pits) {
+    for (int i = 0; i < 2 * pits + 2; i++) {
+        if (values[i] < 0) return false;
+    }
+
+    const int* const rest = values + 2 * pits;
+    return rest[2] >= 1 && (rest[3] == 0 || rest[3] == 1);
+}
+
+/**
+ * "position start [pits stones] [moves M...]", or
+ * "position board pits P1... P2... store1 store2 ply turn [moves M...]".
+ */
+static void commandPosition(Server* server, char** save) {
+    const char* const kind = strtok_r(NULL, " \t", save);
+    char* token = NULL;
+    GameState position = NULL;
+
+    if (kind != NULL && strcmp(kind, "start") == 0) {
+        int pits = 6, stones = 4;
+        token = strtok_r(NULL, " \t", save);
+
+        if (token != NULL && strcmp(token, "moves") != 0) {
+            pits = atoi(token);
+            token = strtok_r(NULL, " \t", save);
+            stones = token != NULL ? atoi(token) : 0;
+            token = strtok_r(NULL, " \t", save);
+        }
+
+        position = stones > 0 ? GameState_initCustom(pits, stones) : NULL;
+    } else if (kind != NULL && strcmp(kind, "board") == 0) {
+        token = strtok_r(NULL, " \t", save);
+        const int pits = token != NULL ? atoi(token) : 0;
+
+        if (pits >= 1 && pits <= GAMESTATE_MAX_PITS) {
+            int values[2 * GAMESTATE_MAX_PITS + 4];
+            int count = 0;
+
+            while (count < 2 * pits + 4 && (token = strtok_r(NULL, " \t", save)) != NULL)
+                values[count++] = atoi(token);
+
+            if (count == 2 * pits + 4 && validBoard(values, pits)) {
+                const int* const rest = values + 2 * pits;
+                position = new_GameState(pits, values, values + pits, rest[0], rest[1], rest[2], rest[3]);
+            }
+
+            token = strtok_r(NULL, " \t", save);
+        }
+    }
+
+    if (position == NULL) {
+        reply(server, "info string invalid position");
+        return;
+    }
+
+    // The position is only replaced if all of its moves are legal.
+    if (token != NULL && strcmp(token, "moves") == 0 && !applyMoves(server, position, save)) {
+        GameState_free(position);
+        return;
+    }
+
+    GameState_free(server->position);
+    server->position = position;
+}
+
+/**
+ * "go [movetime MS] [depth D] [threads N]". Without a time or depth, the
+ * search runs until "stop".
+ */
+static void commandGo(Server* server, char** save) {
+    server->timeLimit = 0;
+    server->maxDepth = SERVER_UNLIMITED_DEPTH;
+    server->threads = 1;
+
+    char* token;
+    while ((token = strtok_r(NULL, " \t", save)) != NULL) {
+        const char* const value = strtok_r(NULL, " \t", save);
+        if (value == NULL) break;
+
+        if (strcmp(token, "movetime") == 0) server->timeLimit = atol(value);
+        else if (strcmp(token, "depth") == 0) server->maxDepth = atoi(value);
+        else if (strcmp(token, "threads") == 0) server->threads = atoi(value);
+    }
+
+    // The search works on its own copy, so the position can change while it runs.
+    server->searchRoot = GameState_copy(server->position);
+    atomic_store(&server->stop, false);
+
+    if (pthread_create(&server->searchThread, NULL, searchThread, server) != 0) {
+        GameState_free(server->searchRoot);
+        server->searchRoot = NULL;
+        reply(server, "info string could not start search");
+        return;
+    }
+
+    server->searching = true;
+}
+
+/**
+ * Answer commands from a client until it disconnects or sends "quit".
+ *
+ * @return Whether the client asked to quit
+ */
+static bool serve(Server* server, FILE* in, FILE* out) {
+    char line[SERVER_MAX_LINE];
+    bool quit = false;
+    server->out = out;
+
+    while (!quit && fgets(line, sizeof(line), in) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char* save;
+        const char* const command = strtok_r(line, " \t", &save);
+        if (command == NULL) continue;
+
+        // Let a search with limits finish before anything else happens, but
+        // stop one without limits (or when quitting).
+        if (server->searching && strcmp(command, "stop") != 0 && strcmp(command, "isready") != 0) {
+            const bool limited = server->timeLimit > 0 || server->maxDepth < SERVER_UNLIMITED_DEPTH;
+            if (limited && strcmp(command, "quit") != 0) waitSearch(server);
+            else stopSearch(server);
+        }
+
+        if (strcmp(command, "position") == 0) {
+            commandPosition(server, &save);
+        } else if (strcmp(command, "go") == 0) {
+            commandGo(server, &save);
+        } else if (strcmp(command, "stop") == 0) {
+            stopSearch(server);
+        } else if (strcmp(command, "newgame") == 0) {
+            stopSearch(server);
+            SearchContext_newGame(server->ctx);
+            GameState_free(server->position);
+            server->position = GameState_initBasic();
+        } else if (strcmp(command, "isready") == 0) {
+            reply(server, "readyok");
+        } else if (strcmp(command, "quit") == 0) {
+            quit = true;
+        } else {
+            reply(server, "info string unknown command %s", command);
+        }
+    }
+
+    // Nothing is left to read the results of a search.
+    stopSearch(server);
+    return quit;
+}
+
+/**
+ * Serve clients of a Unix socket, one at a time, until one sends "quit".
+ */
+static int serveSocket(Server* server, const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", path);
+        return 1;
+    }
+    strcpy(address.sun_path, path);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 1) != 0) {
+        perror(path);
+        return 1;
+    }
+
+    bool quit = false;
+    while (!quit) {
+        const int client = accept(listener, NULL, NULL);
+        if (client < 0) continue;
+
+        FILE* const in = fdopen(client, "r");
+        FILE* const out = fdopen(dup(client), "w");
+        if (in != NULL && out != NULL) quit = serve(server, in, out);
+
+        if (in != NULL) fclose(in);
+        else close(client);
+        if (out != NULL) fclose(out);
+    }
+
+    close(listener);
+    unlink(path);
+    return 0;
+}
+
+
+/**
+ * Long-lived engine process, speaking a line protocol on stdin / stdout or a
+ * Unix socket. The search context (and its memory) is kept between requests.
+ *
+ * Commands:
+ *   position start [pits stones] [moves M...]
+ *   position board pits P1... P2... store1 store2 ply turn [moves M...]
+ *   go [movetime MS] [depth D] [threads N]
+ *   stop
+ *   newgame
+ *   isready
+ *   quit
+ *
+ * A board's counts cannot be negative, its ply starts at 1 and its turn is 0
+ * or 1. A position with an illegal move is rejected, and the previous one kept.
+ *
+ * Replies:
+ *   info depth D score S nodes N time T pv M...   (after every iteration; N is the
+ *                                                  iteration's nodes on the main thread)
+ *   bestmove M                                     (when a search ends)
+ *   readyok
+ *   info string MESSAGE
+ *
+ * Usage: mancalamax_server [--socket PATH]
+ */
+int main(int argc, char** argv) {
+    Server server;
+    memset(&server, 0, sizeof(server));
+
+    server.ctx = new_SearchContext(MINIMAX_DEFAULT_TABLE_ENTRIES);
+    server.position = GameState_initBasic();
+    if (server.ctx == NULL || server.position == NULL) return 1;
+
+    pthread_mutex_init(&server.outLock, NULL);
+    atomic_init(&server.stop, false);
+    SearchContext_setStopFlag(server.ctx, &server.stop);
+    SearchContext_setCallback(server.ctx, reportIteration, &server);
+
+    // A client can ponder with "go" on its predicted position and "stop": what
+    // that search learns stays in the table for the next one.
+    SearchContext_setKeepTable(server.ctx, true);
+
+    int status = 0;
+    if (argc > 2 && strcmp(argv[1], "--socket") == 0)
+        status = serveSocket(&server, argv[2]);
+    else
+        serve(&server, stdin, stdout);
+
+    pthread_mutex_destroy(&server.outLock);
+    GameState_free(server.position);
+    SearchContext_free(server.ctx);
+
+    return status;
+}
@@ -2,32 +2,124 @@
  * project:  Mancalamax
  * file:     state.c
  * author:   Ethan Mentzer
- * modified: 2025-03-08
+ * modified: 2026-10-16
  */
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #include "state.h"
 #include "../utils/LinkedList.h"
 
 
+// Zobrist key slots. Pits use player * GAMESTATE_MAX_PITS + pit, the rest follow.
+#define ZOBRIST_SEED 0x6d616e63616c6121ULL
+#define ZOBRIST_PIT_SLOT(player, pit) ((unsigned)((player) * GAMESTATE_MAX_PITS + (pit)))
+#define ZOBRIST_STORE_SLOT(player) ((unsigned)(2 * GAMESTATE_MAX_PITS + (player)))
+#define ZOBRIST_TURN_SLOT ((unsigned)(2 * GAMESTATE_MAX_PITS + 2))
+#define ZOBRIST_PIE_SLOT ((unsigned)(2 * GAMESTATE_MAX_PITS + 3))
+#define ZOBRIST_SLOTS (2 * GAMESTATE_MAX_PITS + 4)
+
+// Keys for small counts are cached, since they are needed for every stone sown.
+#define ZOBRIST_CACHED_COUNTS 64
+static uint64_t zobristCache[ZOBRIST_SLOTS][ZOBRIST_CACHED_COUNTS];
+static pthread_once_t zobristCacheOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * SplitMix64 finalizer, used to derive Zobrist keys on demand.
+ */
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
 /**
- * The GameState struct represents a Mancala game state.
+ * Derives the Zobrist key for a slot (pit, store, or flag) holding a given count.
+ * Keys come from a fixed seed rather than a random table, so any stone count is
+ * supported and hashes are stable across processes. Empty slots hash to 0.
  */
-struct GameState {
-    int* players[2];
-    int stores[2];
-    int pits;
-    int ply;
-    int currentTurn;
-};
+static uint64_t zobristKey(const unsigned slot, const int count) {
+    if (count == 0) return 0;
+    return mix64(ZOBRIST_SEED ^ ((uint64_t)slot << 32) ^ (uint32_t)count);
+}
+
+static void initZobristCache() {
+    for (unsigned slot = 0; slot < ZOBRIST_SLOTS; slot++) {
+        for (int count = 0; count < ZOBRIST_CACHED_COUNTS; count++)
+            zobristCache[slot][count] = zobristKey(slot, count);
+    }
+}
+
+/**
+ * Returns the Zobrist key for a slot holding a given count, using the cache when possible.
+ */
+static uint64_t zobrist(const unsigned slot, const int count) {
+    if (count >= 0 && count < ZOBRIST_CACHED_COUNTS) return zobristCache[slot][count];
+    return zobristKey(slot, count);
+}
+
+/**
+ * Whether the "PIE" move is available at a given ply.
+ */
+static bool pieAvailable(const int ply) {
+    return ply == 2;
+}
+
+/**
+ * Computes the Zobrist hash of a state from scratch.
+ */
+static uint64_t computeHash(GameState state) {
+    uint64_t hash = 0;
+
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i < state->pits; i++)
+            hash ^= zobrist(ZOBRIST_PIT_SLOT(player, i), state->players[player][i]);
+        hash ^= zobrist(ZOBRIST_STORE_SLOT(player), state->stores[player]);
+    }
+
+    hash ^= zobrist(ZOBRIST_TURN_SLOT, state->currentTurn);
+    hash ^= zobrist(ZOBRIST_PIE_SLOT, pieAvailable(state->ply));
+
+    return hash;
+}
+
+/**
+ * Sets the number of stones in a pit, keeping the hash up to date.
+ */
+static void setPit(GameState state, const int player, const int pit, const int count) {
+    const unsigned slot = ZOBRIST_PIT_SLOT(player, pit);
+    state->hash ^= zobrist(slot, state->players[player][pit]) ^ zobrist(slot, count);
+    state->players[player][pit] = count;
+}
+
+/**
+ * Sets the number of stones in a store, keeping the hash up to date.
+ */
+static void setStore(GameState state, const int player, const int count) {
+    const unsigned slot = ZOBRIST_STORE_SLOT(player);
+    state->hash ^= zobrist(slot, state->stores[player]) ^ zobrist(slot, count);
+    state->stores[player] = count;
+}
+
+/**
+ * Advances the ply counter, keeping the hash up to date.
+ */
+static void nextPly(GameState state) {
+    state->hash ^= zobrist(ZOBRIST_PIE_SLOT, pieAvailable(state->ply));
+    state->ply++;
+    state->hash ^= zobrist(ZOBRIST_PIE_SLOT, pieAvailable(state->ply));
+}
 
 static void switchTurn(GameState state) {
     if (state == NULL) return;
+    state->hash ^= zobrist(ZOBRIST_TURN_SLOT, state->currentTurn);
     state->currentTurn = state->currentTurn == 0 ? 1 : 0;
+    state->hash ^= zobrist(ZOBRIST_TURN_SLOT, state->currentTurn);
 }
 
 /**
@@ -36,9 +128,11 @@ static void switchTurn(GameState state) {
 static void rotateBoard(GameState state) {
     if (state == NULL) return;
 
-    int* oldPlayer1 = state->players[0];
-    state->players[0] = state->players[1];
-    state->players[1] = oldPlayer1;
+    for (int i = 0; i < state->pits; i++) {
+        const int oldPit1 = state->players[0][i];
+        state->players[0][i] = state->players[1][i];
+        state->players[1][i] = oldPit1;
+    }
 
     const int oldStore1 = state->stores[0];
     state->stores[0] = state->stores[1];
@@ -55,51 +149,146 @@ static int arraySum(const int* array, const int size) {
     return sum;
 }
 
+/*
+ * Sowing walks a cycle of 2 * pits + 1 positions, from the mover's point of view:
+ * positions [0, pits) are the mover's pits, position pits is the mover's store,
+ * and positions (pits, 2 * pits] are the opponent's pits. The opponent's store
+ * is not on the cycle, so it is skipped automatically.
+ *
+ * Sowing s stones from a pit gives every position s / (2 * pits + 1) stones
+ * for the full laps, plus one more to each of the next s % (2 * pits + 1)
+ * positions after the pit. Those are, in order: the mover's pits after the
+ * sown one, the store, the opponent's pits, and the mover's pits before the
+ * sown one. So the stones are added a run at a time rather than a stone at a
+ * time, and long moves cost no more than short ones.
+ */
+
+/**
+ * The runs of positions that get one stone more than the full laps give.
+ */
+typedef struct SowRuns {
+    int after;      // the mover's pits after the sown one
+    int store;      // 1 if the mover's store is reached
+    int opponent;   // the opponent's pits, from the first
+    int before;     // the mover's pits, from the first (never reaching the sown pit)
+} SowRuns;
+
+static SowRuns splitSowing(const int pits, const int pit, const int rest) {
+    SowRuns runs;
+    int left = rest;
+
+    runs.after = left < pits - pit - 1 ? left : pits - pit - 1;
+    left -= runs.after;
+    runs.store = left > 0 ? 1 : 0;
+    left -= runs.store;
+    runs.opponent = left < pits ? left : pits;
+    runs.before = left - runs.opponent;
+
+    return runs;
+}
+
+// The standard game gets its own kernels, with the pit count known at compile time.
+#define KERNEL(name) name##_6
+#define KERNEL_PITS(state) 6
+#include "state_kernels.h"
+#undef KERNEL
+#undef KERNEL_PITS
+
+#define KERNEL(name) name##_n
+#define KERNEL_PITS(state) ((state)->pits)
+#include "state_kernels.h"
+#undef KERNEL
+#undef KERNEL_PITS
+
+/**
+ * Picks the kernel for a state's pit count.
+ */
+#define GAMESTATE_DISPATCH(state, name) ((state)->pits == 6 ? name##_6 : name##_n)
+
 
 GameState new_GameState(
     const int pits,
-    int* player1,
-    int* player2,
+    const int* player1,
+    const int* player2,
     const int store1,
     const int store2,
     const int ply,
     const int currentTurn)
 {
-    struct GameState* const newState = (GameState)malloc(sizeof(struct GameState));
+    return new_GameStateIn(NULL, pits, player1, player2, store1, store2, ply, currentTurn);
+}
 
-    newState->pits = pits;
-    newState->players[0] = player1;
-    newState->players[1] = player2;
-    newState->stores[0] = store1;
-    newState->stores[1] = store2;
-    newState->ply = ply;
-    newState->currentTurn = currentTurn;
+GameState new_GameStateIn(
+    Arena arena,
+    const int pits,
+    const int* player1,
+    const int* player2,
+    const int store1,
+    const int store2,
+    const int ply,
+    const int currentTurn)
+{
+    if (pits < 1 || pits > GAMESTATE_MAX_PITS) return NULL;
+
+    struct GameState* const newState = (GameState)Arena_acquire(arena, sizeof(struct GameState));
+    if (newState == NULL) return NULL;
+    GameState_set(newState, pits, player1, player2, store1, store2, ply, currentTurn);
 
     return newState;
 }
 
-void GameState_free(GameState state) {
-    if (state == NULL) return;
+bool GameState_set(
+    GameState state,
+    const int pits,
+    const int* player1,
+    const int* player2,
+    const int store1,
+    const int store2,
+    const int ply,
+    const int currentTurn)
+{
+    if (state == NULL || pits < 1 || pits > GAMESTATE_MAX_PITS) return false;
 
-    for (int player = 0; player < 2; player++) {
-        free(state->players[player]);
-    }
+    // Every state starts here, so this is where the key cache gets filled.
+    pthread_once(&zobristCacheOnce, initZobristCache);
+
+    memset(state, 0, sizeof(struct GameState));
+    memcpy(state->players[0], player1, sizeof(int)*pits);
+    memcpy(state->players[1], player2, sizeof(int)*pits);
 
-    free(state);
+    state->pits = pits;
+    state->stores[0] = store1;
+    state->stores[1] = store2;
+    state->ply = ply;
+    state->currentTurn = currentTurn;
+    state->hash = computeHash(state);
+
+    return true;
+}
+
+void GameState_free(GameState state) {
+    if (state == NULL) return;
+    Arena_release(state);
 }
 
 GameState GameState_initCustom(const int pits, const int stonesPerPit) {
-    if (pits < 1 || stonesPerPit < 1) return NULL;
+    struct GameState initial;
+    if (!GameState_initCustomInto(&initial, pits, stonesPerPit)) return NULL;
+    return GameState_copy(&initial);
+}
 
-    int* player1 = (int*)calloc(sizeof(int), pits);
-    int* player2 = (int*)calloc(sizeof(int), pits);
+bool GameState_initCustomInto(GameState state, const int pits, const int stonesPerPit) {
+    if (pits < 1 || pits > GAMESTATE_MAX_PITS || stonesPerPit < 1) return false;
+
+    int player1[GAMESTATE_MAX_PITS];
+    int player2[GAMESTATE_MAX_PITS];
 
     for (int i = 0; i < pits; i++) {
         player1[i] = stonesPerPit;
         player2[i] = stonesPerPit;
     }
 
-    return new_GameState(pits, player1, player2, 0, 0, 1, 0);
+    return GameState_set(state, pits, player1, player2, 0, 0, 1, 0);
 }
 
 GameState GameState_initBasic() {
@@ -107,21 +296,17 @@ GameState GameState_initBasic() {
 }
 
 GameState GameState_copy(GameState state) {
+    return GameState_copyIn(NULL, state);
+}
+
+GameState GameState_copyIn(Arena arena, GameState state) {
     if (state == NULL) return NULL;
 
-    int *player1 = (int*)calloc(sizeof(int), state->pits);
-    int *player2 = (int*)calloc(sizeof(int), state->pits);
-    memcpy(player1, state->players[0], sizeof(int)*state->pits);
-    memcpy(player2, state->players[1], sizeof(int)*state->pits);
+    struct GameState* const newState = (GameState)Arena_acquire(arena, sizeof(struct GameState));
+    if (newState == NULL) return NULL;
+    *newState = *state;
 
-    return new_GameState(
-        state->pits,
-        player1,
-        player2,
-        state->stores[0],
-        state->stores[1],
-        state->ply,
-        state->currentTurn);
+    return newState;
 }
 
 void GameState_print(GameState state, const bool newline) {
@@ -145,33 +330,54 @@ void GameState_print(GameState state, const bool newline) {
 
 bool GameState_isTerminal(GameState state) {
     if (state == NULL) return false;
-
-    for (int player = 0; player < 2; player++) {
-        for (int i = 0; i < state->pits; i++) {
-            if (state->players[player][i] != 0) return false;
-        }
-    }
-
-    return true;
+    return GAMESTATE_DISPATCH(state, isTerminal)(state);
 }
 
 LinkedList GameState_getValidMoves(GameState state) {
     if (state == NULL) return NULL;
 
+    MoveList moves;
+    GameState_generateMoves(state, &moves);
+
     LinkedList newList = new_LinkedList();
-    const int player = state->currentTurn;
+    for (int i = 0; i < moves.size; i++) LinkedList_append(newList, moves.moves[i]);
+
+    return newList;
+}
+
+int GameState_generateMoves(GameState state, MoveList* moves) {
+    if (state == NULL || moves == NULL) return 0;
+    return GAMESTATE_DISPATCH(state, generateMoves)(state, moves);
+}
+
+int GameState_classifyMove(GameState state, const int pit, int* captured) {
+    if (captured != NULL) *captured = 0;
+    if (state == NULL || pit < 1 || pit > state->pits) return 0;
+    return GAMESTATE_DISPATCH(state, classifyMove)(state, pit, captured);
+}
 
-    // If the "PIE" move is available for player 2.
-    if (player == 1 && state->ply == 2)  // NOTE: was "|| state->ply == 3"
-        LinkedList_prepend(newList, -1);
+bool MoveList_contains(const MoveList* moves, const int move) {
+    if (moves == NULL) return false;
 
-    // List all pits where the number of stones != 0.
-    for (int pit = 0; pit < state->pits; pit++) {
-        if (state->players[player][pit] != 0)
-            LinkedList_prepend(newList, pit+1);
+    for (int i = 0; i < moves->size; i++) {
+        if (moves->moves[i] == move) return true;
     }
 
-    return newList;
+    return false;
+}
+
+bool MoveList_moveToFront(MoveList* moves, const int move) {
+    if (moves == NULL) return false;
+
+    for (int i = 0; i < moves->size; i++) {
+        if (moves->moves[i] != move) continue;
+
+        for (int j = i; j > 0; j--) moves->moves[j] = moves->moves[j - 1];
+        moves->moves[0] = move;
+        return true;
+    }
+
+    return false;
 }
 
 int GameState_getCurrentTurn(GameState state) {
@@ -184,107 +390,38 @@ int GameState_getScore(GameState state, const int player) {
     return state->stores[player];
 }
 
-GameState GameState_move(GameState state, int pit, const bool autoFree) {
+uint64_t GameState_getHash(GameState state) {
+    if (state == NULL) return 0;
+    return state->hash;
+}
+
+GameState GameState_move(GameState state, const int pit, const bool autoFree) {
     if (state == NULL) return NULL;
 
-    // Make a copy of the current state.
+    // Make a copy of the current state, and apply the move to it.
     GameState newState = GameState_copy(state);
+    GameState_moveInto(state, pit, newState);
 
     // Free the old state, if requested by the user.
     if (autoFree) GameState_free(state);
 
-    // Handle "PIE" input.
-    if (pit == -1) {
-        rotateBoard(newState);
-        switchTurn(newState);
-        newState->ply++;
-        return newState;
-    }
-
-    // Get current player, find adjusted pit index, and collect number of stones to distribute.
-    int* player = newState->players[newState->currentTurn];
-    pit--;
-    const int stones = player[pit];
-    player[pit] = 0;
-    pit++;
-
-    // Initialize turn variables.
-    int side = newState->currentTurn;  // used to determine whether to place stones in store
-    bool goAgain = false;  // used if last stone ends up in a store
-
-    // Distribute the stones of the selected pit.
-    for (int i = 0; i < stones; i++) {
-        const bool lastStone = i == stones - 1;
-
-        if (pit != newState->pits) {
-            // Add stone to pit.
-            player[pit]++;
-        } else {
-            // Only add stones to the current player's store.
-            const bool addToStore = side == newState->currentTurn;
-            if (addToStore) {
-                newState->stores[side]++;
-                if (lastStone) goAgain = true;
-            }
-
-            // Switch board sides.
-            side = side == 0 ? 1 : 0;
-            player = newState->players[side];
-            pit = 0;
-
-            // If we did not add to the store, make sure to add one to the next player's store.
-            // If we DID add to the store, and if that wasn't the last stone, add one to the
-            // next player's store, and increment i to avoid adding two stones for the same i.
-            if (!addToStore) {
-                player[pit]++;
-            } else if (!lastStone) {
-                player[pit]++;
-                i++;
-            }
-        }
-
-        // Determine which stones to capture (if any).
-        if (lastStone && side == newState->currentTurn && player[pit] == 1) {
-            int toCapture[2] = {-1, -1};
-
-            if (side == 0) {
-                toCapture[0] = pit;
-                toCapture[1] = newState->pits - pit - 1;
-            } else {
-                toCapture[0] = newState->pits - pit - 1;
-                toCapture[1] = pit;
-            }
-
-            newState->stores[side] += newState->players[0][toCapture[0]];
-            newState->stores[side] += newState->players[1][toCapture[1]];
-            newState->players[0][toCapture[0]] = 0;
-            newState->players[1][toCapture[1]] = 0;
-        }
-
-        pit++;
-    }
+    return newState;
+}
 
-    // Detect completed game.
-    int finalStoneRecipient = -1;
-    if (arraySum(newState->players[0], newState->pits) == 0)
-        finalStoneRecipient = 1;
-    else if (arraySum(newState->players[1], newState->pits) == 0)
-        finalStoneRecipient = 0;
-
-    // If game is finished, player with stones on their side captures them all.
-    if (finalStoneRecipient != -1) {
-        player = newState->players[finalStoneRecipient];
-        for (int i = 0; i < newState->pits; i++) {
-            newState->stores[finalStoneRecipient] += player[i];
-            player[i] = 0;
-        }
-    }
+void GameState_moveInto(GameState state, const int pit, GameState newState) {
+    if (state == NULL || newState == NULL) return;
+    if (newState != state) *newState = *state;
 
-    // Don't switch players if player goes again.
-    if (!goAgain)
-        switchTurn(newState);
+    GameStateUndo undo;
+    GameState_makeMove(newState, pit, &undo);
+}
 
-    newState->ply++;
+void GameState_makeMove(GameState state, const int pit, GameStateUndo* undo) {
+    if (state == NULL || undo == NULL) return;
+    GAMESTATE_DISPATCH(state, makeMove)(state, pit, undo);
+}
 
-    return newState;
+void GameState_unmakeMove(GameState state, const GameStateUndo* undo) {
+    if (state == NULL || undo == NULL) return;
+    GAMESTATE_DISPATCH(state, unmakeMove)(state, undo);
 }
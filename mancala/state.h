@@ -2,24 +2,86 @@
  * project:  Mancalamax
  * file:     state.h
  * author:   Ethan Mentzer
- * modified: 2025-03-08
+ * modified: 2026-10-16
  */
 
 #ifndef STATE_H
 #define STATE_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "../utils/Arena.h"
 #include "../utils/LinkedList.h"
 
+/**
+ * The maximum number of pits per player supported by GameState_initCustom.
+ */
+#define GAMESTATE_MAX_PITS 16
+
+/**
+ * The maximum number of moves available in any state (every pit, plus "PIE").
+ */
+#define GAMESTATE_MAX_MOVES (GAMESTATE_MAX_PITS + 1)
+
 /**
  * The GameState struct represents a Mancala game state.
+ *
+ * The pits are stored inline, so a struct GameState is a plain value: it can be
+ * copied by assignment or memcpy, and can live on the stack. The GameState
+ * pointer type is used by the rest of the API, and works with both heap
+ * states (from new_GameState, GameState_copy, etc.) and stack states.
+ *
+ * Only the first "pits" entries of each player array are used.
  */
+struct GameState {
+    int players[2][GAMESTATE_MAX_PITS];
+    int stores[2];
+    int pits;
+    int ply;
+    int currentTurn;
+    uint64_t hash;
+};
+
 typedef struct GameState* GameState;
 
 /**
- * Initialize a new GameState.
+ * The information needed to take back a move applied with GameState_makeMove.
+ * Only the fixed-size fields are written for most moves; the swept array is
+ * only filled when the move ends the game.
+ */
+typedef struct GameStateUndo {
+    uint64_t hash;
+    int stores[2];
+    int ply;
+    int currentTurn;
+    int pit;          // 0-based pit that was sown, or -1 for the "PIE" move
+    int stones;       // number of stones sown from the pit
+    int capturePit;   // mover's pit where a capture happened, or -1
+    int captured;     // stones taken from the pit opposite capturePit
+    int sweptPlayer;  // player whose pits were swept into their store at game end, or -1
+    int swept[GAMESTATE_MAX_PITS];
+} GameStateUndo;
+
+/**
+ * Flags returned by GameState_classifyMove.
+ */
+#define GAMESTATE_MOVE_EXTRA_TURN 1  // the last stone lands in the mover's store
+#define GAMESTATE_MOVE_CAPTURE 2     // the last stone lands in an empty pit on the mover's side
+
+/**
+ * A fixed-capacity list of moves, meant to live on the caller's stack.
+ * Moves are stored in moves[0] to moves[size - 1].
+ */
+typedef struct MoveList {
+    int moves[GAMESTATE_MAX_MOVES];
+    int size;
+} MoveList;
+
+/**
+ * Initialize a new heap-allocated GameState.
  *
- * The player1 and player2 arrays must both be of size pits.
+ * The player1 and player2 arrays must both be of size pits, and are
+ * copied into the state (the caller keeps ownership of them).
  *
  * @param pits The number of pits per player
  * @param player1 An array pointer representing the pits of player 1
@@ -28,19 +90,50 @@ typedef struct GameState* GameState;
  * @param store2 The number of stones in player 2's store
  * @param ply The current ply number
  * @param currentTurn The player allowed to make the next move (0 or 1)
- * @return A pointer to an initialized GameState struct.
+ * @return A pointer to an initialized GameState struct, or NULL if pits is out of range.
  */
 extern GameState new_GameState(
     int pits,
-    int* player1,
-    int* player2,
+    const int* player1,
+    const int* player2,
     int store1,
     int store2,
     int ply,
     int currentTurn);
 
 /**
- * Free the memory used by a GameState, including the player arrays.
+ * Initialize a new GameState allocated from an Arena (or the heap, if arena is NULL).
+ * Takes the same remaining arguments as new_GameState. Arena states are reclaimed
+ * by the arena, so GameState_free is a no-op for them.
+ */
+extern GameState new_GameStateIn(
+    Arena arena,
+    int pits,
+    const int* player1,
+    const int* player2,
+    int store1,
+    int store2,
+    int ply,
+    int currentTurn);
+
+/**
+ * Initialize an existing (e.g. stack-allocated) GameState in place.
+ * Takes the same arguments as new_GameState.
+ *
+ * @return Whether the state was initialized (false if pits is out of range)
+ */
+extern bool GameState_set(
+    GameState state,
+    int pits,
+    const int* player1,
+    const int* player2,
+    int store1,
+    int store2,
+    int ply,
+    int currentTurn);
+
+/**
+ * Free the memory used by a heap-allocated GameState. Does nothing for arena states.
  */
 extern void GameState_free(GameState state);
 
@@ -48,12 +141,19 @@ extern void GameState_free(GameState state);
  * Start a new game with a certain number of pits, and a
  * certain number of stones per pit.
  *
- * @param pits The number of pits per player
+ * @param pits The number of pits per player (at most GAMESTATE_MAX_PITS)
  * @param stonesPerPit The number of stones per pit
  * @return A pointer to an initialized GameState struct.
  */
 extern GameState GameState_initCustom(int pits, int stonesPerPit);
 
+/**
+ * Start a new custom game in an existing (e.g. stack-allocated) GameState.
+ *
+ * @return Whether the state was initialized
+ */
+extern bool GameState_initCustomInto(GameState state, int pits, int stonesPerPit);
+
 /**
  * Start a new classic game (6 pits per player, 4 stones per pit).
  */
@@ -64,6 +164,12 @@ extern GameState GameState_initBasic();
  */
 extern GameState GameState_copy(GameState state);
 
+/**
+ * Returns a pointer to a copy of the given state, allocated from an Arena
+ * (or the heap, if arena is NULL).
+ */
+extern GameState GameState_copyIn(Arena arena, GameState state);
+
 /**
  * Display the game state in a useful manner. Prints a preceding
  * newline if desired.
@@ -80,6 +186,40 @@ extern bool GameState_isTerminal(GameState state);
  */
 extern LinkedList GameState_getValidMoves(GameState state);
 
+/**
+ * Fill a MoveList with the valid moves for the current player, without allocating.
+ * Moves are listed in the same order as GameState_getValidMoves: highest pit
+ * first, with the "PIE" move (-1) last when it is available.
+ *
+ * @param state The state to generate moves for
+ * @param moves The list to fill
+ * @return The number of moves generated
+ */
+extern int GameState_generateMoves(GameState state, MoveList* moves);
+
+/**
+ * Work out where a move's last stone lands without applying the move, for
+ * cheap move ordering.
+ *
+ * @param state The state the move would be applied to
+ * @param pit The pit number to sow from (integer, current player's perspective), or -1 for "PIE"
+ * @param captured Set to the number of stones a capture would win, or 0 (can be NULL)
+ * @return A combination of the GAMESTATE_MOVE_* flags (0 for a quiet move)
+ */
+extern int GameState_classifyMove(GameState state, int pit, int* captured);
+
+/**
+ * Returns whether a MoveList contains a move.
+ */
+extern bool MoveList_contains(const MoveList* moves, int move);
+
+/**
+ * Move a move to the front of a MoveList, keeping the order of the others.
+ *
+ * @return Whether the move was found in the list
+ */
+extern bool MoveList_moveToFront(MoveList* moves, int move);
+
 /**
  * Returns the player allowed to make the next move (0 or 1).
  */
@@ -90,6 +230,13 @@ extern int GameState_getCurrentTurn(GameState state);
  */
 extern int GameState_getScore(GameState state, int player);
 
+/**
+ * Returns the Zobrist hash of the state. The hash covers both boards,
+ * both stores, the player to move, and whether the "PIE" move is
+ * available. It is maintained incrementally by GameState_move.
+ */
+extern uint64_t GameState_getHash(GameState state);
+
 /**
  * Apply a move to the current state, given a pit.
  * If the "PIE" rule move is available, the pit input can be -1.
@@ -103,5 +250,35 @@ extern int GameState_getScore(GameState state, int player);
  */
 extern GameState GameState_move(GameState state, int pit, bool autoFree);
 
+/**
+ * Apply a move to a state, writing the result into newState without
+ * allocating. newState may be a stack-allocated state, or the same
+ * state as the input to apply the move in place.
+ *
+ * @param state The state to apply the move to
+ * @param pit The pit number to sow from (integer, current player's perspective)
+ * @param newState The state to write the result to
+ */
+extern void GameState_moveInto(GameState state, int pit, GameState newState);
+
+/**
+ * Apply a move to a state in place, recording what is needed to take it back.
+ * The result is the same as GameState_move.
+ *
+ * @param state The state to modify
+ * @param pit The pit number to sow from (integer, current player's perspective), or -1 for "PIE"
+ * @param undo Filled with the information needed by GameState_unmakeMove
+ */
+extern void GameState_makeMove(GameState state, int pit, GameStateUndo* undo);
+
+/**
+ * Take back the last move applied with GameState_makeMove, restoring the
+ * state (including its hash) exactly. Moves must be taken back in reverse order.
+ *
+ * @param state The state to restore
+ * @param undo The record filled in by GameState_makeMove
+ */
+extern void GameState_unmakeMove(GameState state, const GameStateUndo* undo);
+
 
 #endif //STATE_H
@@ -0,0 +1,272 @@
+/*
+ * project:  Mancalamax
+ * file:     state_kernels.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+/*
+ * The board kernels of state.c, written once and compiled once per pit count.
+ *
+ * This file has no include guard: state.c includes it several times, each time
+ * with these macros defined:
+ *
+ *   KERNEL(name)        the name of a kernel in this specialization (e.g. name##_6)
+ *   KERNEL_PITS(state)  the number of pits per player: a constant, or state->pits
+ *
+ * With a constant pit count, every loop over the pits has a fixed trip count,
+ * so the compiler unrolls them and turns the sowing arithmetic (division by the
+ * cycle length, capture index math) into constants. The generic version reads
+ * the pit count from the state. The public functions in state.c pick a version
+ * with GAMESTATE_DISPATCH.
+ *
+ * The kernels assume their arguments have already been checked.
+ */
+
+static bool KERNEL(isTerminal)(GameState state) {
+    const int pits = KERNEL_PITS(state);
+
+    // Combining the pits without an early exit keeps the loop branch-free.
+    int stones = 0;
+    for (int i = 0; i < pits; i++) stones |= state->players[0][i] | state->players[1][i];
+
+    return stones == 0;
+}
+
+static int KERNEL(generateMoves)(GameState state, MoveList* moves) {
+    const int pits = KERNEL_PITS(state);
+    const int player = state->currentTurn;
+    const int* const own = state->players[player];
+    int size = 0;
+
+    // List all pits where the number of stones != 0, highest first.
+    for (int pit = pits - 1; pit >= 0; pit--) {
+        moves->moves[size] = pit + 1;
+        size += own[pit] != 0;
+    }
+
+    // If the "PIE" move is available for player 2.
+    if (player == 1 && state->ply == 2)  // NOTE: was "|| state->ply == 3"
+        moves->moves[size++] = -1;
+
+    moves->size = size;
+    return size;
+}
+
+static int KERNEL(classifyMove)(GameState state, int pit, int* captured) {
+    const int mover = state->currentTurn;
+    const int pits = KERNEL_PITS(state);
+    const int cycle = 2 * pits + 1;
+    pit--;
+
+    const int stones = state->players[mover][pit];
+    if (stones == 0) return 0;
+
+    // Every position on the cycle gets one stone per full lap, and the
+    // positions up to the landing one get one more.
+    const int laps = stones / cycle;
+    const int rest = stones % cycle;
+    const int landing = (pit + stones) % cycle;
+
+    if (landing == pits) return GAMESTATE_MOVE_EXTRA_TURN;
+    if (landing > pits) return 0;
+
+    // The sown pit starts out empty, and only gets stones from full laps.
+    const int landed = landing == pit
+        ? laps
+        : state->players[mover][landing] + laps + 1;
+    if (landed != 1) return 0;
+
+    if (captured != NULL) {
+        // The opposite pit is at cycle position 2 * pits - landing, and gets an
+        // extra stone if that position is passed before the landing one.
+        const int opposite = pits - landing - 1;
+        const int offset = (2 * pits - landing - pit + cycle) % cycle;
+        const bool passed = offset >= 1 && offset <= rest;
+        *captured = 1 + state->players[mover == 0 ? 1 : 0][opposite] + laps + (passed ? 1 : 0);
+    }
+
+    return GAMESTATE_MOVE_CAPTURE;
+}
+
+/**
+ * Sow the stones taken from a pit (which must already be empty), keeping the
+ * hash up to date.
+ */
+static void KERNEL(sow)(GameState state, const int pit, const int stones) {
+    const int mover = state->currentTurn;
+    const int opponent = mover == 0 ? 1 : 0;
+    const int pits = KERNEL_PITS(state);
+    const int cycle = 2 * pits + 1;
+    const int laps = stones / cycle;
+    const SowRuns runs = splitSowing(pits, pit, stones % cycle);
+
+    int* const own = state->players[mover];
+    int* const other = state->players[opponent];
+
+    if (laps == 0) {
+        // Short moves only touch the pits in the runs.
+        for (int i = pit + 1; i <= pit + runs.after; i++) setPit(state, mover, i, own[i] + 1);
+        if (runs.store) setStore(state, mover, state->stores[mover] + 1);
+        for (int i = 0; i < runs.opponent; i++) setPit(state, opponent, i, other[i] + 1);
+        for (int i = 0; i < runs.before; i++) setPit(state, mover, i, own[i] + 1);
+        return;
+    }
+
+    // Long moves change every pit, so the counts are updated together and then hashed.
+    int before[2][GAMESTATE_MAX_PITS];
+    memcpy(before[0], own, sizeof(int) * pits);
+    memcpy(before[1], other, sizeof(int) * pits);
+
+    for (int i = 0; i < pits; i++) {
+        own[i] += laps;
+        other[i] += laps;
+    }
+
+    for (int i = pit + 1; i <= pit + runs.after; i++) own[i]++;
+    for (int i = 0; i < runs.opponent; i++) other[i]++;
+    for (int i = 0; i < runs.before; i++) own[i]++;
+
+    for (int i = 0; i < pits; i++) {
+        const unsigned ownSlot = ZOBRIST_PIT_SLOT(mover, i);
+        const unsigned otherSlot = ZOBRIST_PIT_SLOT(opponent, i);
+        state->hash ^= zobrist(ownSlot, before[0][i]) ^ zobrist(ownSlot, own[i])
+            ^ zobrist(otherSlot, before[1][i]) ^ zobrist(otherSlot, other[i]);
+    }
+
+    setStore(state, mover, state->stores[mover] + laps + runs.store);
+}
+
+/**
+ * Take back the stones sown from a pit. The hash and stores are restored by the caller.
+ */
+static void KERNEL(unsow)(GameState state, const int mover, const int pit, const int stones) {
+    const int pits = KERNEL_PITS(state);
+    const int cycle = 2 * pits + 1;
+    const int laps = stones / cycle;
+    const SowRuns runs = splitSowing(pits, pit, stones % cycle);
+
+    int* const own = state->players[mover];
+    int* const other = state->players[mover == 0 ? 1 : 0];
+
+    for (int i = pit + 1; i <= pit + runs.after; i++) own[i]--;
+    for (int i = 0; i < runs.opponent; i++) other[i]--;
+    for (int i = 0; i < runs.before; i++) own[i]--;
+
+    if (laps > 0) {
+        for (int i = 0; i < pits; i++) {
+            own[i] -= laps;
+            other[i] -= laps;
+        }
+    }
+
+    own[pit] = stones;
+}
+
+static void KERNEL(makeMove)(GameState state, int pit, GameStateUndo* undo) {
+    undo->hash = state->hash;
+    undo->stores[0] = state->stores[0];
+    undo->stores[1] = state->stores[1];
+    undo->ply = state->ply;
+    undo->currentTurn = state->currentTurn;
+    undo->pit = -1;
+    undo->stones = 0;
+    undo->capturePit = -1;
+    undo->captured = 0;
+    undo->sweptPlayer = -1;
+
+    // Handle "PIE" input.
+    if (pit == -1) {
+        rotateBoard(state);
+        state->hash = computeHash(state);
+        switchTurn(state);
+        nextPly(state);
+        return;
+    }
+
+    // Get current player, find adjusted pit index, and collect number of stones to distribute.
+    const int mover = state->currentTurn;
+    const int opponent = mover == 0 ? 1 : 0;
+    const int pits = KERNEL_PITS(state);
+    const int cycle = 2 * pits + 1;
+    pit--;
+    const int stones = state->players[mover][pit];
+    setPit(state, mover, pit, 0);
+
+    undo->pit = pit;
+    undo->stones = stones;
+
+    // Distribute the stones of the selected pit. The last one lands at a known position.
+    KERNEL(sow)(state, pit, stones);
+    const int pos = (pit + stones) % cycle;
+
+    // If the last stone lands in an empty pit on the mover's side, capture it and the opposite pit.
+    if (stones > 0 && pos < pits && state->players[mover][pos] == 1) {
+        const int opposite = pits - pos - 1;
+        const int captured = state->players[opponent][opposite];
+
+        undo->capturePit = pos;
+        undo->captured = captured;
+
+        setStore(state, mover, state->stores[mover] + 1 + captured);
+        setPit(state, mover, pos, 0);
+        setPit(state, opponent, opposite, 0);
+    }
+
+    // Detect completed game.
+    int finalStoneRecipient = -1;
+    if (arraySum(state->players[0], pits) == 0)
+        finalStoneRecipient = 1;
+    else if (arraySum(state->players[1], pits) == 0)
+        finalStoneRecipient = 0;
+
+    // If game is finished, player with stones on their side captures them all.
+    if (finalStoneRecipient != -1) {
+        undo->sweptPlayer = finalStoneRecipient;
+        const int* const player = state->players[finalStoneRecipient];
+        int sum = 0;
+
+        for (int i = 0; i < pits; i++) {
+            undo->swept[i] = player[i];
+            sum += player[i];
+            setPit(state, finalStoneRecipient, i, 0);
+        }
+
+        setStore(state, finalStoneRecipient, state->stores[finalStoneRecipient] + sum);
+    }
+
+    // Don't switch players if the last stone ended up in the mover's store.
+    if (stones == 0 || pos != pits)
+        switchTurn(state);
+
+    nextPly(state);
+}
+
+static void KERNEL(unmakeMove)(GameState state, const GameStateUndo* undo) {
+    if (undo->pit == -1) {
+        rotateBoard(state);
+    } else {
+        const int mover = undo->currentTurn;
+        const int opponent = mover == 0 ? 1 : 0;
+        const int pits = KERNEL_PITS(state);
+
+        // Put back stones swept at the end of the game, and any captured stones.
+        if (undo->sweptPlayer != -1) {
+            for (int i = 0; i < pits; i++) state->players[undo->sweptPlayer][i] = undo->swept[i];
+        }
+
+        if (undo->capturePit != -1) {
+            state->players[mover][undo->capturePit] = 1;
+            state->players[opponent][pits - undo->capturePit - 1] = undo->captured;
+        }
+
+        // Take back the sown stones. Stores are restored below.
+        KERNEL(unsow)(state, mover, undo->pit, undo->stones);
+    }
+
+    state->stores[0] = undo->stores[0];
+    state->stores[1] = undo->stores[1];
+    state->ply = undo->ply;
+    state->currentTurn = undo->currentTurn;
+    state->hash = undo->hash;
+}
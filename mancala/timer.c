@@ -0,0 +1,124 @@
+/*
+ * project:  Mancalamax
+ * file:     timer.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "timer.h"
+
+
+/**
+ * Time manager for an iterative deepening search.
+ */
+struct Timer {
+    // Start of the search, and its limits (in ms, relative to the start).
+    double start;
+    double softLimit;
+    double hardLimit;
+
+    // Polls left until the clock is read again, and whether the hard limit has passed.
+    int pollsLeft;
+    bool expired;
+
+    // Completed iterations: how many, the time the last one ended, and the
+    // time and nodes of the last three (most recent first).
+    int iterations;
+    double lastEnd;
+    double iterationTimes[3];
+    size_t iterationNodes[3];
+};
+
+/**
+ * Helper function to read the monotonic clock in milliseconds.
+ */
+static double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000 + (double)ts.tv_nsec / 1000000;
+}
+
+
+Timer new_Timer() {
+    struct Timer* const newTimer = (Timer)malloc(sizeof(struct Timer));
+    if (newTimer == NULL) return NULL;
+
+    Timer_start(newTimer, 0, 0);
+    return newTimer;
+}
+
+void Timer_free(Timer timer) {
+    free(timer);
+}
+
+void Timer_start(Timer timer, const time_t softLimit, const time_t hardLimit) {
+    if (timer == NULL) return;
+
+    timer->start = nowMs();
+    timer->hardLimit = hardLimit > 0 ? (double)hardLimit : INFINITY;
+    timer->softLimit = softLimit > 0 && (hardLimit <= 0 || softLimit < hardLimit) ? (double)softLimit : timer->hardLimit;
+    timer->pollsLeft = TIMER_POLL_INTERVAL;
+    timer->expired = false;
+    timer->iterations = 0;
+    timer->lastEnd = 0;
+}
+
+bool Timer_poll(Timer timer) {
+    if (timer == NULL) return false;
+    if (timer->expired) return true;
+    if (--timer->pollsLeft > 0) return false;
+
+    timer->pollsLeft = TIMER_POLL_INTERVAL;
+    timer->expired = nowMs() - timer->start >= timer->hardLimit;
+
+    return timer->expired;
+}
+
+void Timer_endIteration(Timer timer, const size_t nodes) {
+    if (timer == NULL) return;
+
+    const double now = nowMs() - timer->start;
+
+    for (int i = 2; i > 0; i--) {
+        timer->iterationTimes[i] = timer->iterationTimes[i - 1];
+        timer->iterationNodes[i] = timer->iterationNodes[i - 1];
+    }
+
+    timer->iterationTimes[0] = now - timer->lastEnd;
+    timer->iterationNodes[0] = nodes;
+    timer->lastEnd = now;
+    timer->iterations++;
+}
+
+bool Timer_canStartIteration(Timer timer) {
+    if (timer == NULL) return true;
+    if (timer->expired) return false;
+
+    const double elapsed = Timer_getElapsed(timer);
+    if (elapsed >= timer->softLimit) return false;
+
+    // Without a branching factor there is nothing to predict from, so always try.
+    const double branchingFactor = Timer_getBranchingFactor(timer);
+    if (branchingFactor == 0) return true;
+
+    return elapsed + timer->iterationTimes[0] * branchingFactor < timer->hardLimit;
+}
+
+double Timer_getElapsed(Timer timer) {
+    if (timer == NULL) return 0;
+    return nowMs() - timer->start;
+}
+
+double Timer_getBranchingFactor(Timer timer) {
+    if (timer == NULL || timer->iterations < 2 || timer->iterationNodes[1] == 0) return 0;
+
+    // Extra turns make odd and even depths grow differently, so average over
+    // two steps when possible.
+    if (timer->iterations >= 3 && timer->iterationNodes[2] > 0)
+        return sqrt((double)timer->iterationNodes[0] / (double)timer->iterationNodes[2]);
+
+    return (double)timer->iterationNodes[0] / (double)timer->iterationNodes[1];
+}
@@ -0,0 +1,86 @@
+/*
+ * project:  Mancalamax
+ * file:     timer.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * The number of Timer_poll calls between clock reads.
+ */
+#define TIMER_POLL_INTERVAL 1024
+
+/**
+ * Time manager for an iterative deepening search.
+ *
+ * A search has a soft limit, after which no new iteration is started, and
+ * a hard limit, at which the running iteration is stopped. The clock is only
+ * read every TIMER_POLL_INTERVAL polls, and the cost of the next iteration is
+ * predicted from the branching factor of the completed ones, so an iteration
+ * that cannot finish before the hard limit is never started.
+ */
+typedef struct Timer* Timer;
+
+/**
+ * Create a new Timer, with no limits.
+ *
+ * @return A pointer to the new Timer, or NULL if allocation failed
+ */
+extern Timer new_Timer();
+
+/**
+ * Free the memory used by a Timer.
+ */
+extern void Timer_free(Timer timer);
+
+/**
+ * Start timing a new search, forgetting the iterations of any earlier one.
+ *
+ * @param timer The Timer to start
+ * @param softLimit Time (in ms) after which no new iteration should start (0 for the hard limit)
+ * @param hardLimit Time (in ms) after which the search must stop (0 for no limit)
+ */
+extern void Timer_start(Timer timer, time_t softLimit, time_t hardLimit);
+
+/**
+ * Check the hard limit. Called at every node; the clock is only read every
+ * TIMER_POLL_INTERVAL calls. Once the limit has passed, it keeps returning true.
+ *
+ * @return Whether the hard limit has passed
+ */
+extern bool Timer_poll(Timer timer);
+
+/**
+ * Record that an iteration of the search completed.
+ *
+ * @param timer The Timer of the search
+ * @param nodes The number of nodes the iteration visited
+ */
+extern void Timer_endIteration(Timer timer, size_t nodes);
+
+/**
+ * Decide whether to start another iteration: the soft limit must not have
+ * passed, and the predicted time of the iteration must fit before the hard limit.
+ */
+extern bool Timer_canStartIteration(Timer timer);
+
+/**
+ * Returns the time (in ms) since the search started.
+ */
+extern double Timer_getElapsed(Timer timer);
+
+/**
+ * Returns the effective branching factor of the completed iterations:
+ * the growth in nodes from one iteration to the next (0 if unknown).
+ */
+extern double Timer_getBranchingFactor(Timer timer);
+
+
+#endif //TIMER_H
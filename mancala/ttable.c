@@ -0,0 +1,208 @@
+/*
+ * project:  Mancalamax
+ * file:     ttable.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "ttable.h"
+
+
+// Number of TTable_age calls an entry survives. Older entries read as misses.
+#define TTABLE_MAX_AGE 8
+
+/**
+ * A single table entry. The table is shared between search threads without
+ * locks, so an entry is three independent words, and the key is stored
+ * XORed with the other two. A reader that sees a half-written entry gets a
+ * key mismatch, and treats it as a miss.
+ *
+ * The data word packs (from the low bits up): depth + 1 (16 bits, 0 for an
+ * unused entry), bound (8 bits), best move (8 bits) and generation (16 bits).
+ */
+typedef struct TTEntry {
+    _Atomic uint64_t check;
+    _Atomic uint64_t value;
+    _Atomic uint64_t data;
+} TTEntry;
+
+/**
+ * Fixed-size transposition table, indexed by GameState Zobrist hashes.
+ */
+struct TTable {
+    TTEntry* entries;
+    size_t mask;
+    uint16_t generation;
+};
+
+static uint64_t packData(const int depth, const TTBound bound, const int bestMove, const uint16_t generation) {
+    return (uint64_t)(uint16_t)(depth + 1)
+        | (uint64_t)(uint8_t)bound << 16
+        | (uint64_t)(uint8_t)(int8_t)bestMove << 24
+        | (uint64_t)generation << 32;
+}
+
+static int dataDepth(const uint64_t data) {
+    return (int)(data & 0xffff) - 1;
+}
+
+static uint16_t dataGeneration(const uint64_t data) {
+    return (uint16_t)(data >> 32);
+}
+
+/**
+ * Whether an entry was stored in the current generation, or few enough
+ * TTable_age calls ago to still be used.
+ */
+static bool isLive(TTable table, const uint64_t data) {
+    return data != 0 && (uint16_t)(table->generation - dataGeneration(data)) <= TTABLE_MAX_AGE;
+}
+
+static uint64_t doubleBits(const double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(const uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * Wipe every entry (only needed on creation, and when the generation wraps around).
+ */
+static void wipe(TTable table) {
+    for (size_t i = 0; i <= table->mask; i++) {
+        atomic_store_explicit(&table->entries[i].check, 0, memory_order_relaxed);
+        atomic_store_explicit(&table->entries[i].value, 0, memory_order_relaxed);
+        atomic_store_explicit(&table->entries[i].data, 0, memory_order_relaxed);
+    }
+}
+
+
+TTable new_TTable(size_t entries) {
+    if (entries < 1) return NULL;
+
+    // Round down to a power of two, so the index is a simple mask.
+    size_t size = 1;
+    while (size <= entries / 2) size *= 2;
+
+    struct TTable* const newTable = (TTable)malloc(sizeof(struct TTable));
+    if (newTable == NULL) return NULL;
+
+    newTable->entries = (TTEntry*)malloc(sizeof(TTEntry) * size);
+    if (newTable->entries == NULL) {
+        free(newTable);
+        return NULL;
+    }
+
+    newTable->mask = size - 1;
+    newTable->generation = 0;
+    wipe(newTable);
+    TTable_clear(newTable);
+
+    return newTable;
+}
+
+void TTable_free(TTable table) {
+    if (table == NULL) return;
+    free(table->entries);
+    free(table);
+}
+
+void TTable_clear(TTable table) {
+    if (table == NULL) return;
+
+    // Invalidate all entries at once by skipping past the generations they can
+    // live for. Entries only need to be wiped when the counter wraps around.
+    const uint16_t previous = table->generation;
+    table->generation += TTABLE_MAX_AGE + 1;
+    if (table->generation < previous) wipe(table);
+}
+
+void TTable_age(TTable table) {
+    if (table == NULL) return;
+
+    const uint16_t previous = table->generation;
+    table->generation++;
+    if (table->generation < previous) wipe(table);
+}
+
+bool TTable_probe(
+    TTable table,
+    const uint64_t key,
+    double* value,
+    int* depth,
+    TTBound* bound,
+    int* bestMove)
+{
+    if (table == NULL) return false;
+
+    TTEntry* const entry = &table->entries[key & table->mask];
+    const uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+    const uint64_t valueBits = atomic_load_explicit(&entry->value, memory_order_relaxed);
+    const uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+
+    if (!isLive(table, data) || (check ^ valueBits ^ data) != key) return false;
+
+    *value = bitsDouble(valueBits);
+    *depth = dataDepth(data);
+    *bound = (TTBound)(uint8_t)(data >> 16);
+    *bestMove = (int8_t)(uint8_t)(data >> 24);
+
+    return true;
+}
+
+bool TTable_store(
+    TTable table,
+    const uint64_t key,
+    const double value,
+    const int depth,
+    const TTBound bound,
+    const int bestMove)
+{
+    if (table == NULL) return false;
+
+    TTEntry* const entry = &table->entries[key & table->mask];
+    const uint64_t oldCheck = atomic_load_explicit(&entry->check, memory_order_relaxed);
+    const uint64_t oldValue = atomic_load_explicit(&entry->value, memory_order_relaxed);
+    const uint64_t oldData = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    bool overwrite = false;
+
+    if (isLive(table, oldData)) {
+        const bool samePosition = (oldCheck ^ oldValue ^ oldData) == key;
+
+        // Keep deeper results for the same position, however old: they are still exact.
+        if (samePosition && dataDepth(oldData) > depth) return false;
+        overwrite = !samePosition && dataGeneration(oldData) == table->generation;
+    }
+
+    const uint64_t valueBits = doubleBits(value);
+    const uint64_t data = packData(depth, bound, bestMove, table->generation);
+
+    atomic_store_explicit(&entry->value, valueBits, memory_order_relaxed);
+    atomic_store_explicit(&entry->data, data, memory_order_relaxed);
+    atomic_store_explicit(&entry->check, key ^ valueBits ^ data, memory_order_relaxed);
+
+    return overwrite;
+}
+
+size_t TTable_getEntries(TTable table) {
+    if (table == NULL) return 0;
+    return table->mask + 1;
+}
+
+size_t TTable_entriesForBytes(const size_t bytes) {
+    if (bytes < sizeof(struct TTable) + sizeof(TTEntry)) return 0;
+    const size_t fit = (bytes - sizeof(struct TTable)) / sizeof(TTEntry);
+
+    size_t size = 1;
+    while (size <= fit / 2) size *= 2;
+    return size;
+}
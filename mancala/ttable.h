@@ -0,0 +1,94 @@
+/*
+ * project:  Mancalamax
+ * file:     ttable.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The kind of bound a stored search value represents.
+ */
+typedef enum TTBound {
+    TT_EXACT,  // the value is the exact minimax value
+    TT_LOWER,  // the search failed high; the true value is >= the stored value
+    TT_UPPER   // the search failed low; the true value is <= the stored value
+} TTBound;
+
+/**
+ * Fixed-size transposition table, indexed by GameState Zobrist hashes.
+ *
+ * A table can be shared by several search threads without locking: entries
+ * are verified against the probed key, so a torn write reads as a miss.
+ * TTable_clear and TTable_age must not run concurrently with probes or stores.
+ */
+typedef struct TTable* TTable;
+
+/**
+ * Create a new transposition table. The entry count is rounded down
+ * to a power of two.
+ *
+ * @param entries The number of entries to allocate (at least 1)
+ * @return A pointer to an empty TTable, or NULL if allocation failed
+ */
+extern TTable new_TTable(size_t entries);
+
+/**
+ * Free the memory used by a TTable.
+ */
+extern void TTable_free(TTable table);
+
+/**
+ * Remove all entries from a TTable.
+ */
+extern void TTable_clear(TTable table);
+
+/**
+ * Start a new generation of entries, keeping the existing ones. Entries from
+ * earlier generations are still found by probes, until they are overwritten or
+ * have been aged a few times (after which they are treated as removed).
+ */
+extern void TTable_age(TTable table);
+
+/**
+ * Look up a position in the table.
+ *
+ * @param table The table to search
+ * @param key The Zobrist hash of the position
+ * @param value Set to the stored value on a hit
+ * @param depth Set to the remaining search depth the value was computed with
+ * @param bound Set to the bound type of the stored value
+ * @param bestMove Set to the best move found for the position (-2 if none)
+ * @return Whether the position was found
+ */
+extern bool TTable_probe(TTable table, uint64_t key, double* value, int* depth, TTBound* bound, int* bestMove);
+
+/**
+ * Store a search result. An entry for a different position is always replaced;
+ * an entry for the same position is only replaced by an equal or deeper search.
+ *
+ * @return Whether an entry for a different position, stored in the current generation, was overwritten
+ */
+extern bool TTable_store(TTable table, uint64_t key, double value, int depth, TTBound bound, int bestMove);
+
+/**
+ * Returns the number of entries in the table.
+ */
+extern size_t TTable_getEntries(TTable table);
+
+/**
+ * Returns the largest number of entries a table can have within a memory budget.
+ *
+ * @param bytes The memory budget
+ * @return The entry count (a power of two), or 0 if not even one entry fits
+ */
+extern size_t TTable_entriesForBytes(size_t bytes);
+
+
+#endif //TTABLE_H
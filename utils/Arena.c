@@ -0,0 +1,166 @@
+/*
+ * project:  Mancalamax
+ * file:     Arena.c
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <stdalign.h>
+
+#include "Arena.h"
+
+
+/**
+ * A block of Arena memory. Blocks form a list, and are reused after a reset.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+} ArenaBlock;
+
+/**
+ * Bump allocator for short-lived objects.
+ */
+struct Arena {
+    ArenaBlock* first;
+    ArenaBlock* current;
+    size_t blockSize;
+    size_t bytesInUse;
+    size_t peakBytes;
+    size_t allocations;
+};
+
+/**
+ * Header placed in front of memory from Arena_acquire, recording where it came from.
+ */
+typedef union ArenaTag {
+    Arena arena;
+    max_align_t align;
+} ArenaTag;
+
+/**
+ * Helper function to round a size up to the maximum alignment.
+ */
+static size_t alignSize(const size_t size) {
+    const size_t align = alignof(max_align_t);
+    return (size + align - 1) / align * align;
+}
+
+static ArenaBlock* new_ArenaBlock(const size_t size) {
+    ArenaBlock* const block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size);
+    if (block == NULL) return NULL;
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+
+    return block;
+}
+
+
+Arena new_Arena(const size_t blockSize) {
+    struct Arena* const newArena = (Arena)malloc(sizeof(struct Arena));
+    if (newArena == NULL) return NULL;
+
+    newArena->blockSize = alignSize(blockSize == 0 ? ARENA_DEFAULT_BLOCK_SIZE : blockSize);
+    newArena->first = new_ArenaBlock(newArena->blockSize);
+    newArena->current = newArena->first;
+    newArena->bytesInUse = 0;
+    newArena->peakBytes = 0;
+    newArena->allocations = 0;
+
+    if (newArena->first == NULL) {
+        free(newArena);
+        return NULL;
+    }
+
+    return newArena;
+}
+
+void Arena_free(Arena arena) {
+    if (arena == NULL) return;
+
+    ArenaBlock* block = arena->first;
+    while (block != NULL) {
+        ArenaBlock* const next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
+void* Arena_alloc(Arena arena, const size_t size) {
+    if (arena == NULL) return NULL;
+
+    const size_t needed = alignSize(size);
+    ArenaBlock* block = arena->current;
+
+    // Move on to the next block (reusing one from before a reset, if it is big enough).
+    if (block->used + needed > block->size) {
+        ArenaBlock* next = block->next;
+
+        if (next == NULL || next->size < needed) {
+            next = new_ArenaBlock(needed > arena->blockSize ? needed : arena->blockSize);
+            if (next == NULL) return NULL;
+            next->next = block->next;
+            block->next = next;
+        }
+
+        next->used = 0;
+        arena->current = block = next;
+    }
+
+    void* const ptr = block->data + block->used;
+    block->used += needed;
+
+    arena->bytesInUse += needed;
+    if (arena->bytesInUse > arena->peakBytes) arena->peakBytes = arena->bytesInUse;
+    arena->allocations++;
+
+    return ptr;
+}
+
+void Arena_reset(Arena arena) {
+    if (arena == NULL) return;
+
+    arena->first->used = 0;
+    arena->current = arena->first;
+    arena->bytesInUse = 0;
+}
+
+void* Arena_acquire(Arena arena, const size_t size) {
+    ArenaTag* const tag = arena == NULL
+        ? (ArenaTag*)malloc(sizeof(ArenaTag) + size)
+        : (ArenaTag*)Arena_alloc(arena, sizeof(ArenaTag) + size);
+    if (tag == NULL) return NULL;
+
+    tag->arena = arena;
+    return tag + 1;
+}
+
+void Arena_release(void* ptr) {
+    if (ptr == NULL) return;
+
+    ArenaTag* const tag = (ArenaTag*)ptr - 1;
+    if (tag->arena == NULL) free(tag);
+}
+
+size_t Arena_getPeakBytes(Arena arena) {
+    if (arena == NULL) return 0;
+    return arena->peakBytes;
+}
+
+size_t Arena_getAllocations(Arena arena) {
+    if (arena == NULL) return 0;
+    return arena->allocations;
+}
+
+void Arena_resetStats(Arena arena) {
+    if (arena == NULL) return;
+    arena->peakBytes = arena->bytesInUse;
+    arena->allocations = 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * project:  Mancalamax
+ * file:     Arena.h
+ * author:   Ethan Mentzer
+ * modified: 2026-10-16
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+
+/**
+ * Bump allocator for short-lived objects. Memory is handed out from large
+ * blocks and reclaimed all at once by Arena_reset, which keeps the blocks
+ * for reuse. Individual allocations cannot be freed.
+ */
+typedef struct Arena* Arena;
+
+/**
+ * The default block size of an Arena, in bytes.
+ */
+#define ARENA_DEFAULT_BLOCK_SIZE ((size_t)64 * 1024)
+
+/**
+ * Create a new, empty Arena.
+ *
+ * @param blockSize The size of each block (0 for ARENA_DEFAULT_BLOCK_SIZE)
+ * @return A pointer to the new Arena, or NULL if allocation failed
+ */
+extern Arena new_Arena(size_t blockSize);
+
+/**
+ * Free an Arena, along with everything allocated from it.
+ */
+extern void Arena_free(Arena arena);
+
+/**
+ * Allocate memory from an Arena. The memory is suitably aligned for any type,
+ * and stays valid until the next Arena_reset or Arena_free.
+ *
+ * @return A pointer to the memory, or NULL if allocation failed
+ */
+extern void* Arena_alloc(Arena arena, size_t size);
+
+/**
+ * Release everything allocated from an Arena at once. The blocks are kept for reuse.
+ */
+extern void Arena_reset(Arena arena);
+
+/**
+ * Allocate memory for an object that may or may not live in an Arena.
+ * If arena is NULL the memory comes from the heap. Either way, the object
+ * must be released with Arena_release, which only frees heap memory.
+ *
+ * @param arena The Arena to allocate from, or NULL for the heap
+ * @param size The size of the object
+ * @return A pointer to the memory, or NULL if allocation failed
+ */
+extern void* Arena_acquire(Arena arena, size_t size);
+
+/**
+ * Release memory from Arena_acquire. Heap memory is freed; Arena memory is
+ * left alone, since it is reclaimed by Arena_reset.
+ */
+extern void Arena_release(void* ptr);
+
+/**
+ * Returns the largest number of bytes in use at once since the last Arena_resetStats.
+ */
+extern size_t Arena_getPeakBytes(Arena arena);
+
+/**
+ * Returns the number of allocations made since the last Arena_resetStats.
+ */
+extern size_t Arena_getAllocations(Arena arena);
+
+/**
+ * Reset the peak byte and allocation counters.
+ */
+extern void Arena_resetStats(Arena arena);
+
+
+#endif //ARENA_H
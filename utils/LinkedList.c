@@ -2,7 +2,7 @@
  * project:  Mancalamax
  * file:     LinkedList.c
  * author:   Ethan Mentzer
- * modified: 2025-03-08
+ * modified: 2026-10-16
  */
 
 #include <stdlib.h>
@@ -20,7 +20,11 @@ struct Node {
 };
 
 Node new_Node(const int value) {
-    struct Node* const newNode = (Node)malloc(sizeof(struct Node));
+    return new_NodeIn(NULL, value);
+}
+
+Node new_NodeIn(Arena arena, const int value) {
+    struct Node* const newNode = (Node)Arena_acquire(arena, sizeof(struct Node));
     newNode->value = value;
     newNode->next = NULL;
     return newNode;
@@ -28,7 +32,7 @@ Node new_Node(const int value) {
 
 void Node_free(Node node) {
     if (node == NULL) return;
-    free(node);
+    Arena_release(node);
 }
 
 int Node_value(Node node) {
@@ -49,10 +53,16 @@ struct LinkedList {
     Node head;
     Node tail;
     size_t size;
+    Arena arena;
 };
 
 LinkedList new_LinkedList() {
-    struct LinkedList* const newList = (LinkedList)malloc(sizeof(struct LinkedList));
+    return new_LinkedListIn(NULL);
+}
+
+LinkedList new_LinkedListIn(Arena arena) {
+    struct LinkedList* const newList = (LinkedList)Arena_acquire(arena, sizeof(struct LinkedList));
+    newList->arena = arena;
     newList->head = NULL;
     newList->tail = NULL;
     newList->size = 0;
@@ -62,15 +72,18 @@ LinkedList new_LinkedList() {
 void LinkedList_free(LinkedList list) {
     if (list == NULL) return;
 
+    // Arena lists and their Nodes are reclaimed by the arena.
+    if (list->arena != NULL) return;
+
     Node toFree = list->head;
 
     while (toFree != NULL) {
         struct Node* const next = toFree->next;
-        free(toFree);
+        Node_free(toFree);
         toFree = next;
     }
 
-    free(list);
+    Arena_release(list);
 }
 
 size_t LinkedList_size(LinkedList list) {
@@ -82,10 +95,10 @@ void LinkedList_append(LinkedList list, const int value) {
     if (list == NULL) return;
 
     if (list->head == NULL) {
-        list->head = new_Node(value);
+        list->head = new_NodeIn(list->arena, value);
         list->tail = list->head;
     } else {
-        list->tail->next = new_Node(value);
+        list->tail->next = new_NodeIn(list->arena, value);
         list->tail = list->tail->next;
     }
 
@@ -96,10 +109,10 @@ void LinkedList_prepend(LinkedList list, const int value) {
     if (list == NULL) return;
 
     if (list->head == NULL) {
-        list->head = new_Node(value);
+        list->head = new_NodeIn(list->arena, value);
         list->tail = list->head;
     } else {
-        struct Node* const newNode = new_Node(value);
+        struct Node* const newNode = new_NodeIn(list->arena, value);
         newNode->next = list->head;
         list->head = newNode;
     }
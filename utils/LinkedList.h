@@ -2,12 +2,14 @@
  * project:  Mancalamax
  * file:     LinkedList.h
  * author:   Ethan Mentzer
- * modified: 2025-03-08
+ * modified: 2026-10-16
  */
 
 #ifndef LINKEDLIST_H
 #define LINKEDLIST_H
 
+#include <stddef.h>
+#include "Arena.h"
 
 /**
  * Linked list node implementation for integers.
@@ -15,16 +17,22 @@
 typedef struct Node* Node;
 
 extern Node new_Node(int value);
+extern Node new_NodeIn(Arena arena, int value);
 extern void Node_free(Node node);
 extern int Node_value(Node node);
 extern Node Node_next(Node node);
 
 /**
  * Linked list implementation for integer Nodes.
+ *
+ * The "In" constructors take an Arena to allocate from (or NULL for the heap).
+ * A list allocates its Nodes from the same place as itself. Freeing arena
+ * objects is a no-op, since the arena reclaims them on reset.
  */
 typedef struct LinkedList* LinkedList;
 
 extern LinkedList new_LinkedList();
+extern LinkedList new_LinkedListIn(Arena arena);
 extern void LinkedList_free(LinkedList list);
 extern size_t LinkedList_size(LinkedList list);
 extern void LinkedList_append(LinkedList list, int value);